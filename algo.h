@@ -3,7 +3,11 @@
 
 #include "stl_iterator.h"
 #include "type_traits.h"
+#include "stl_pair.h"
+#include "stl_simd.h"
+#include "heap.h"
 #include <cstring>
+#include <utility>
 
 
 // 为了避免某些算法函数被标准C++的头文件引入，因此我们自己写的方法必须要写在 `MYSTL` 命名空间下
@@ -35,9 +39,9 @@ namespace MYSTL
     OutputIterator adjacent_difference(InputIterator first, InputIterator last, OutputIterator result) {
         if(first == last) return result;
         *result = *first;
-        iterator_traits<InputIterator>::value_type value = *first;
+        typename iterator_traits<InputIterator>::value_type value = *first;
         while(++first != last) {
-            iterator_traits<InputIterator>::value_type tmp = *first;
+            typename iterator_traits<InputIterator>::value_type tmp = *first;
             *++result = tmp - value;
             value = tmp;
         }
@@ -48,9 +52,9 @@ namespace MYSTL
     OutputIterator adjacent_difference(InputeIterator first, InputeIterator last, OutputIterator result, BinaryOperator binary_op) {
         if(first == last) return result;
         *result = *first;
-        iterator_traits<InputeIterator>::value_type value = *first;
+        typename iterator_traits<InputeIterator>::value_type value = *first;
         while(++first != last) {
-            iterator_traits<InputeIterator>::value_type tmp = *first;
+            typename iterator_traits<InputeIterator>::value_type tmp = *first;
             *++result = binary_op(tmp, value);
             tmp = value;
         }
@@ -61,7 +65,7 @@ namespace MYSTL
      *  inner_product : 计算两个迭代器所指的内积，并加在init上
      *  提供两个版本，版本一使用默认乘法算内积，版本二使用用户自定义的二元操作BinaryOperator
     */
-    template<typename InputIterator1, typename InputIterator2, typenmae T>
+    template<typename InputIterator1, typename InputIterator2, typename T>
     T inner_producate(InputIterator1 first1, InputIterator1 last1, T init, InputIterator2 first2) {
         for(; first1 != last1; ++first1, ++first2)
             init = init + (*first1 * *first2); 
@@ -84,7 +88,7 @@ namespace MYSTL
     OutputIterator partial_sum(InputIterator first, InputIterator last, OutputIterator result) {
         if(first == last) return result;
         *result = *first;
-        iterator_traits<InputIterator>::value_type value = *first;
+        typename iterator_traits<InputIterator>::value_type value = *first;
         while(++first != last) {
             value = value + *first;
             *++result = value;
@@ -96,7 +100,7 @@ namespace MYSTL
     OutputIterator partial_sum(InputIterator first, InputIterator last, OutputIterator result, BinnaryOperator binnary_op) {
         if(first == last) return result;
         *result = *first;
-        iterator_traits<InputIterator>::value_type value = *first;
+        typename iterator_traits<InputIterator>::value_type value = *first;
         while(++first != last) {
             value = binnary_op(value, *first);
             *++result = value;
@@ -136,14 +140,20 @@ namespace MYSTL
     */
     template<class T>
     void swap(T& a, T& b){
-        T tmp = a;
-        a = b;
-        b = tmp;
+        T tmp = std::move(a);
+        a = std::move(b);
+        b = std::move(tmp);
+    }
+
+    // 交换两个迭代器所指的元素
+    template<class ForwardIterator1, class ForwardIterator2>
+    inline void iter_swap(ForwardIterator1 a, ForwardIterator2 b){
+        MYSTL::swap(*a, *b);
     }
 
     /*****copy*****/
     template <class RandomAccessIterator, class OutputIterator, class Distance>
-    inline OutputIterator __copy_d(RandomAccessIterator first, RandomAccessIterator last, OutputIterator result, Distance)
+    inline OutputIterator __copy_d(RandomAccessIterator first, RandomAccessIterator last, OutputIterator result, Distance*)
     {
         for(Distance n = last - first; n > 0; --n, ++first, ++result)
             *result = *first;
@@ -153,14 +163,14 @@ namespace MYSTL
 
     // 指针所指对象具备默认赋值操作符
     template <class T>
-    inline T* __copy_t(T* first, T* last, T* result, __true_type) {
+    inline T* __copy_t(const T* first, const T* last, T* result, __true_type) {
         memmove(result, first, sizeof(T) * (last - first));
         return result + (last - first);
     }
 
     // 指针所指对象不具备默认复制操作
     template <class T>
-    inline T* __copy_t(T* first, T* last, T* result, __false_type) {
+    inline T* __copy_t(const T* first, const T* last, T* result, __false_type) {
         return __copy_d(first, last, result, reinterpret_cast<ptrdiff_t *>(0));
     }
 
@@ -196,8 +206,19 @@ namespace MYSTL
         T* operator()(T* first, T* last, T* result)
         {
             // 指针是否有默认的赋值操作
-            typedef typename __type_traits<T>::has_trivial_copy_constructor has_trivial_copy_constructor;
-            return __copy_t(first, last, result, has_trivial_copy_constructor());
+            typedef typename __type_traits<T>::has_trivial_assignment_operator has_trivial_assignment_operator;
+            return __copy_t(first, last, result, has_trivial_assignment_operator());
+        }
+    };
+
+    // 特例化const T*, T*
+    template <class T>
+    struct _copy<const T*, T*>
+    {
+        T* operator()(const T* first, const T* last, T* result)
+        {
+            typedef typename __type_traits<T>::has_trivial_assignment_operator has_trivial_assignment_operator;
+            return __copy_t(first, last, result, has_trivial_assignment_operator());
         }
     };
 
@@ -230,6 +251,65 @@ namespace MYSTL
         return _copy_backward<BidrectionalIterator1, BidrectionalIterator2>()(first, last, result);
     }
 
+    /**********move / move_backward*********/
+    // 与 copy / copy_backward 相同，但以移动赋值代替复制赋值
+    template <class InputIterator, class OutputIterator>
+    inline OutputIterator move(InputIterator first, InputIterator last, OutputIterator result)
+    {
+        for(; first != last; ++first, ++result)
+            *result = std::move(*first);
+        return result;
+    }
+
+    template <class BidirectionalIterator1, class BidirectionalIterator2>
+    inline BidirectionalIterator2 move_backward(BidirectionalIterator1 first, BidirectionalIterator1 last, BidirectionalIterator2 result)
+    {
+        while(last != first)
+            *(--result) = std::move(*(--last));
+        return result;
+    }
+
+    // 指针所指对象的移动赋值是平凡的，整块 memmove
+    template <class T>
+    inline T* __move_t(T* first, T* last, T* result, __true_type) {
+        memmove(result, first, sizeof(T) * (last - first));
+        return result + (last - first);
+    }
+
+    template <class T>
+    inline T* __move_t(T* first, T* last, T* result, __false_type) {
+        for(; first != last; ++first, ++result)
+            *result = std::move(*first);
+        return result;
+    }
+
+    template <class T>
+    inline T* __move_backward_t(T* first, T* last, T* result, __true_type) {
+        memmove(result - (last - first), first, sizeof(T) * (last - first));
+        return result - (last - first);
+    }
+
+    template <class T>
+    inline T* __move_backward_t(T* first, T* last, T* result, __false_type) {
+        while(last != first)
+            *(--result) = std::move(*(--last));
+        return result;
+    }
+
+    template <class T>
+    inline T* move(T* first, T* last, T* result)
+    {
+        typedef typename __bool_type<std::is_trivially_move_assignable<T>::value>::type trivial_move;
+        return __move_t(first, last, result, trivial_move());
+    }
+
+    template <class T>
+    inline T* move_backward(T* first, T* last, T* result)
+    {
+        typedef typename __bool_type<std::is_trivially_move_assignable<T>::value>::type trivial_move;
+        return __move_backward_t(first, last, result, trivial_move());
+    }
+
     template <class ForwardIterator, class T>
     inline void fill(ForwardIterator first, ForwardIterator last, const T &x)
     {
@@ -239,6 +319,216 @@ namespace MYSTL
         }
     }
 
+    // 原生指针上的算术类型交给 __simd_fill() 按位填充
+    template <class T, class U>
+    inline void __fill_t(T* first, T* last, const U &x, __true_type)
+    {
+        const T value = x;
+        if(first != last)
+            __simd_fill(first, last, value);
+    }
+
+    template <class T, class U>
+    inline void __fill_t(T* first, T* last, const U &x, __false_type)
+    {
+        for(; first != last; ++first)
+            *first = x;
+    }
+
+    template <class T, class U>
+    inline void fill(T* first, T* last, const U &x)
+    {
+        typedef typename __bool_type<__simd_fillable<T>::value>::type simd;
+        __fill_t(first, last, x, simd());
+    }
+
+    // 从 first 开始的 n 个元素赋值为 x，返回最后一个被赋值元素的下一个位置
+    template <class OutputIterator, class Size, class T>
+    inline OutputIterator fill_n(OutputIterator first, Size n, const T &x)
+    {
+        for(; n > 0; --n, ++first)
+            *first = x;
+        return first;
+    }
+
+    template <class T, class Size, class U>
+    inline T* fill_n(T* first, Size n, const U &x)
+    {
+        if(!(n > 0))
+            return first;
+        MYSTL::fill(first, first + n, x);
+        return first + n;
+    }
+
+    /**
+     *   count / count_if：统计等于 value、满足 pred 的元素个数
+     *   原生指针上的整数元素交给 __simd_count()，谓词为 __compare_to_value(见 stl_function.h)时同样如此
+    */
+    template<class InputIterator, class T>
+    inline typename iterator_traits<InputIterator>::difference_type
+    count(InputIterator first, InputIterator last, const T &value)
+    {
+        typename iterator_traits<InputIterator>::difference_type n = 0;
+        for(; first != last; ++first)
+            if(*first == value) ++n;
+        return n;
+    }
+
+    template<class T, class U>
+    inline ptrdiff_t __count_t(T* first, T* last, const U &value, __true_type)
+    {
+        typedef typename std::remove_const<T>::type V;
+        const V v = V(value);
+        // value 不能用元素类型表示时不会与任何元素相等
+        if(!(U(v) == value))
+            return 0;
+        return __simd_count<__cmp_eq>(first, last, v);
+    }
+
+    template<class T, class U>
+    inline ptrdiff_t __count_t(T* first, T* last, const U &value, __false_type)
+    {
+        ptrdiff_t n = 0;
+        for(; first != last; ++first)
+            if(*first == value) ++n;
+        return n;
+    }
+
+    template<class T, class U>
+    inline ptrdiff_t count(T* first, T* last, const U &value)
+    {
+        typedef typename __bool_type<__simd_integer<T>::value && std::is_integral<U>::value>::type simd;
+        return __count_t(first, last, value, simd());
+    }
+
+    template<class InputIterator, class Predicate>
+    inline typename iterator_traits<InputIterator>::difference_type
+    count_if(InputIterator first, InputIterator last, Predicate pred)
+    {
+        typename iterator_traits<InputIterator>::difference_type n = 0;
+        for(; first != last; ++first)
+            if(pred(*first)) ++n;
+        return n;
+    }
+
+    template<class T, class U, int Op>
+    inline ptrdiff_t __count_if_t(T* first, T* last, const __compare_to_value<U, Op> &pred, __true_type)
+    {
+        return __simd_count<Op>(first, last, pred.value);
+    }
+
+    template<class T, class U, int Op>
+    inline ptrdiff_t __count_if_t(T* first, T* last, const __compare_to_value<U, Op> &pred, __false_type)
+    {
+        ptrdiff_t n = 0;
+        for(; first != last; ++first)
+            if(pred(*first)) ++n;
+        return n;
+    }
+
+    template<class T, class U, int Op>
+    inline ptrdiff_t count_if(T* first, T* last, __compare_to_value<U, Op> pred)
+    {
+        typedef typename __bool_type<__simd_integer<T>::value &&
+                                     std::is_same<typename std::remove_const<T>::type, U>::value>::type simd;
+        return __count_if_t(first, last, pred, simd());
+    }
+
+    /**
+     *   mismatch / equal：逐个比较 [first1, last1) 与 first2 开始的区间
+     *   mismatch 返回两个区间中第一对不相等元素的位置；equal 判断两个区间是否相等
+     *   两个原生指针指向同一种整数时，mismatch 交给 __simd_mismatch()，equal 交给 memcmp()
+    */
+    template<class InputIterator1, class InputIterator2>
+    inline pair<InputIterator1, InputIterator2>
+    mismatch(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2)
+    {
+        while(first1 != last1 && *first1 == *first2)
+            ++first1, ++first2;
+        return pair<InputIterator1, InputIterator2>(first1, first2);
+    }
+
+    template<class InputIterator1, class InputIterator2, class BinaryPredicate>
+    inline pair<InputIterator1, InputIterator2>
+    mismatch(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, BinaryPredicate pred)
+    {
+        while(first1 != last1 && pred(*first1, *first2))
+            ++first1, ++first2;
+        return pair<InputIterator1, InputIterator2>(first1, first2);
+    }
+
+    template<class T, class U>
+    inline pair<T*, U*> __mismatch_t(T* first1, T* last1, U* first2, __true_type)
+    {
+        const ptrdiff_t n = __simd_mismatch<typename std::remove_const<T>::type>(first1, last1, first2) - first1;
+        return pair<T*, U*>(first1 + n, first2 + n);
+    }
+
+    template<class T, class U>
+    inline pair<T*, U*> __mismatch_t(T* first1, T* last1, U* first2, __false_type)
+    {
+        while(first1 != last1 && *first1 == *first2)
+            ++first1, ++first2;
+        return pair<T*, U*>(first1, first2);
+    }
+
+    template<class T, class U>
+    inline pair<T*, U*> mismatch(T* first1, T* last1, U* first2)
+    {
+        typedef typename __bool_type<__simd_integer<T>::value &&
+                                     std::is_same<typename std::remove_const<T>::type, typename std::remove_const<U>::type>::value>::type simd;
+        return __mismatch_t(first1, last1, first2, simd());
+    }
+
+    template<class InputIterator1, class InputIterator2>
+    inline bool equal(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2)
+    {
+        for(; first1 != last1; ++first1, ++first2)
+            if(!(*first1 == *first2)) return false;
+        return true;
+    }
+
+    template<class InputIterator1, class InputIterator2, class BinaryPredicate>
+    inline bool equal(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, BinaryPredicate pred)
+    {
+        for(; first1 != last1; ++first1, ++first2)
+            if(!pred(*first1, *first2)) return false;
+        return true;
+    }
+
+    template<class T, class U>
+    inline bool __equal_t(T* first1, T* last1, U* first2, __true_type)
+    {
+        return first1 == last1 || 0 == memcmp(first1, first2, (last1 - first1) * sizeof(T));
+    }
+
+    template<class T, class U>
+    inline bool __equal_t(T* first1, T* last1, U* first2, __false_type)
+    {
+        for(; first1 != last1; ++first1, ++first2)
+            if(!(*first1 == *first2)) return false;
+        return true;
+    }
+
+    template<class T, class U>
+    inline bool equal(T* first1, T* last1, U* first2)
+    {
+        typedef typename __bool_type<__simd_integer<T>::value &&
+                                     std::is_same<typename std::remove_const<T>::type, typename std::remove_const<U>::type>::value>::type simd;
+        return __equal_t(first1, last1, first2, simd());
+    }
+
+    // 按字典序比较 [first1, last1) 与 [first2, last2)，前者小于后者时返回 true
+    template<class InputIterator1, class InputIterator2>
+    inline bool lexicographical_compare(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, InputIterator2 last2)
+    {
+        for(; first1 != last1 && first2 != last2; ++first1, ++first2) {
+            if(*first1 < *first2) return true;
+            if(*first2 < *first1) return false;
+        }
+        return first1 == last1 && first2 != last2;
+    }
+
     /**
      *   find函数
     */
@@ -256,6 +546,291 @@ namespace MYSTL
         // 转交给__find_d()执行迭代器相对应的函数执行
         return __find_d(first, last, value, iterator_category(first));
    }
+
+   // 原生指针上的整数元素交给 __simd_find()
+   template<class T, class U>
+   inline T* __find_t(T* first, T* last, const U& value, __true_type)
+   {
+        typedef typename std::remove_const<T>::type V;
+        const V v = V(value);
+        // value 不能用元素类型表示时不会与任何元素相等
+        if(!(U(v) == value))
+            return last;
+        return const_cast<T*>(__simd_find<__cmp_eq>(first, last, v));
+   }
+
+   template<class T, class U>
+   inline T* __find_t(T* first, T* last, const U& value, __false_type)
+   {
+        return __find_d(first, last, value, random_iterator_tag());
+   }
+
+   template<class T, class U>
+   inline T* find(T* first, T* last, const U& value)
+   {
+        typedef typename __bool_type<__simd_integer<T>::value && std::is_integral<U>::value>::type simd;
+        return __find_t(first, last, value, simd());
+   }
+
+   /**
+    *   find_if函数：谓词为 __compare_to_value(见 stl_function.h)、元素为整数时交给 __simd_find()
+   */
+   template<class InputIterator, class Predicate>
+   InputIterator find_if(InputIterator first, InputIterator last, Predicate pred)
+   {
+        while(first != last && !pred(*first))
+            ++first;
+        return first;
+   }
+
+   template<class T, class U, int Op>
+   inline T* __find_if_t(T* first, T* last, const __compare_to_value<U, Op>& pred, __true_type)
+   {
+        return const_cast<T*>(__simd_find<Op>(first, last, pred.value));
+   }
+
+   template<class T, class U, int Op>
+   inline T* __find_if_t(T* first, T* last, const __compare_to_value<U, Op>& pred, __false_type)
+   {
+        while(first != last && !pred(*first))
+            ++first;
+        return first;
+   }
+
+   template<class T, class U, int Op>
+   inline T* find_if(T* first, T* last, __compare_to_value<U, Op> pred)
+   {
+        typedef typename __bool_type<__simd_integer<T>::value &&
+                                     std::is_same<typename std::remove_const<T>::type, U>::value>::type simd;
+        return __find_if_t(first, last, pred, simd());
+   }
+
+    /**
+     *   排序算法：sort / partial_sort / nth_element / is_sorted
+     *   只要求随机访问迭代器(原生指针、deque 迭代器等)，元素通过移动交换位置；不带 comp 的版本使用 operator<
+    */
+    struct __iter_less {
+        template<class T1, class T2>
+        bool operator()(const T1& a, const T2& b) const { return a < b; }
+    };
+
+    // 子区间小于该长度时不再分割，留给插入排序
+    enum { __stl_threshold = 16 };
+
+    // floor(log2(n))，用于限制 introsort 的分割深度
+    template<class Size>
+    inline Size __lg(Size n) {
+        Size k = 0;
+        for(; n > 1; n >>= 1) ++k;
+        return k;
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void __unguarded_linear_insert(RandomAccessIterator last, Compare comp)
+    {
+        // 调用者保证 last 之前有不大于 *last 的元素作为哨兵，循环中不用检查边界
+        typename iterator_traits<RandomAccessIterator>::value_type value = std::move(*last);
+        RandomAccessIterator next = last;
+        --next;
+        while(comp(value, *next)) {
+            *last = std::move(*next);
+            last = next;
+            --next;
+        }
+        *last = std::move(value);
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void __insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        if(first == last) return;
+        for(RandomAccessIterator i = first + 1; i != last; ++i) {
+            if(comp(*i, *first)) {
+                // 比头部还小，整体后移一格后放到头部
+                typename iterator_traits<RandomAccessIterator>::value_type value = std::move(*i);
+                MYSTL::move_backward(first, i, i + 1);
+                *first = std::move(value);
+            } else {
+                MYSTL::__unguarded_linear_insert(i, comp);
+            }
+        }
+    }
+
+    // 前 __stl_threshold 个元素中必有整个区间的最小值，之后的插入排序都以它为哨兵
+    template<class RandomAccessIterator, class Compare>
+    void __final_insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        if(last - first > __stl_threshold) {
+            MYSTL::__insertion_sort(first, first + __stl_threshold, comp);
+            for(RandomAccessIterator i = first + __stl_threshold; i != last; ++i)
+                MYSTL::__unguarded_linear_insert(i, comp);
+        } else {
+            MYSTL::__insertion_sort(first, last, comp);
+        }
+    }
+
+    // 把 *a、*b、*c 的中位数交换到 result
+    template<class Iterator, class Compare>
+    void __move_median_to_first(Iterator result, Iterator a, Iterator b, Iterator c, Compare comp)
+    {
+        if(comp(*a, *b)) {
+            if(comp(*b, *c))        MYSTL::iter_swap(result, b);
+            else if(comp(*a, *c))   MYSTL::iter_swap(result, c);
+            else                    MYSTL::iter_swap(result, a);
+        } else if(comp(*a, *c))     MYSTL::iter_swap(result, a);
+        else if(comp(*b, *c))       MYSTL::iter_swap(result, c);
+        else                        MYSTL::iter_swap(result, b);
+    }
+
+    // 以 *pivot 为枢轴分割 [first, last)，返回右半边的起点；两端都有枢轴挡住，扫描时不检查边界
+    template<class RandomAccessIterator, class Compare>
+    RandomAccessIterator __unguarded_partition(RandomAccessIterator first, RandomAccessIterator last,
+                                               RandomAccessIterator pivot, Compare comp)
+    {
+        while(true) {
+            while(comp(*first, *pivot))
+                ++first;
+            --last;
+            while(comp(*pivot, *last))
+                --last;
+            if(!(first < last))
+                return first;
+            MYSTL::iter_swap(first, last);
+            ++first;
+        }
+    }
+
+    // 首、中、尾三者的中位数作为枢轴放到 first，再分割 [first + 1, last)
+    template<class RandomAccessIterator, class Compare>
+    inline RandomAccessIterator __unguarded_partition_pivot(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        RandomAccessIterator mid = first + (last - first) / 2;
+        MYSTL::__move_median_to_first(first, first + 1, mid, last - 1, comp);
+        return MYSTL::__unguarded_partition(first + 1, last, first, comp);
+    }
+
+    /**
+     *   partial_sort：把 [first, last) 中最小的 middle - first 个元素依序放到 [first, middle)，其余元素顺序不定
+     *   在 [first, middle) 上建大根堆，[middle, last) 中比堆顶小的元素与堆顶交换，最后 sort_heap()
+    */
+    template<class RandomAccessIterator, class Compare>
+    void partial_sort(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, Compare comp)
+    {
+        typedef typename iterator_traits<RandomAccessIterator>::value_type T;
+        typedef typename iterator_traits<RandomAccessIterator>::difference_type Distance;
+        if(first == middle) return;
+        ::make_heap(first, middle, comp);
+        for(RandomAccessIterator i = middle; i < last; ++i)
+            if(comp(*i, *first))
+                ::__pop_heap(first, middle, i, T(std::move(*i)), (Distance*)0, comp);
+        ::sort_heap(first, middle, comp);
+    }
+
+    template<class RandomAccessIterator>
+    inline void partial_sort(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last)
+    {
+        MYSTL::partial_sort(first, middle, last, __iter_less());
+    }
+
+    /**
+     *   sort：introsort(内省排序)
+     *      长度大于 __stl_threshold 的区间以首、中、尾的中位数为枢轴分割，递归处理右半边，在左半边上继续循环；
+     *      分割深度超过 2 * log2(n) 说明枢轴选得很差，剩下的区间改用 partial_sort() 做堆排序，最坏仍为 O(nlogn)；
+     *      短的子区间不排序，最后由一次插入排序整体完成
+    */
+    template<class RandomAccessIterator, class Size, class Compare>
+    void __introsort_loop(RandomAccessIterator first, RandomAccessIterator last, Size depth_limit, Compare comp)
+    {
+        while(last - first > __stl_threshold) {
+            if(0 == depth_limit) {
+                MYSTL::partial_sort(first, last, last, comp);
+                return;
+            }
+            --depth_limit;
+            RandomAccessIterator cut = MYSTL::__unguarded_partition_pivot(first, last, comp);
+            MYSTL::__introsort_loop(cut, last, depth_limit, comp);
+            last = cut;
+        }
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    inline void sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+    {
+        if(last - first < 2) return;
+        MYSTL::__introsort_loop(first, last, MYSTL::__lg(last - first) * 2, comp);
+        MYSTL::__final_insertion_sort(first, last, comp);
+    }
+
+    template<class RandomAccessIterator>
+    inline void sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        MYSTL::sort(first, last, __iter_less());
+    }
+
+    /**
+     *   nth_element：使 *nth 成为排序后应在该位置的元素，之前的元素都不大于它，之后的都不小于它
+     *   与 sort 相同的分割，但每次只进入包含 nth 的一边；分割深度超过限制时改用 partial_sort()
+    */
+    template<class RandomAccessIterator, class Compare>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth, RandomAccessIterator last, Compare comp)
+    {
+        if(first == last || nth == last) return;
+        typename iterator_traits<RandomAccessIterator>::difference_type depth_limit = MYSTL::__lg(last - first) * 2;
+        while(last - first > 3) {
+            if(0 == depth_limit) {
+                MYSTL::partial_sort(first, nth + 1, last, comp);
+                return;
+            }
+            --depth_limit;
+            RandomAccessIterator cut = MYSTL::__unguarded_partition_pivot(first, last, comp);
+            if(!(nth < cut))
+                first = cut;
+            else
+                last = cut;
+        }
+        MYSTL::__insertion_sort(first, last, comp);
+    }
+
+    template<class RandomAccessIterator>
+    inline void nth_element(RandomAccessIterator first, RandomAccessIterator nth, RandomAccessIterator last)
+    {
+        MYSTL::nth_element(first, nth, last, __iter_less());
+    }
+
+    /**
+     *   is_sorted_until：返回第一个比前一个元素小的位置，全部有序时返回 last
+     *   is_sorted：[first, last) 是否有序
+    */
+    template<class ForwardIterator, class Compare>
+    ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last, Compare comp)
+    {
+        if(first == last) return last;
+        ForwardIterator next = first;
+        while(++next != last) {
+            if(comp(*next, *first))
+                return next;
+            first = next;
+        }
+        return last;
+    }
+
+    template<class ForwardIterator>
+    inline ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last)
+    {
+        return MYSTL::is_sorted_until(first, last, __iter_less());
+    }
+
+    template<class ForwardIterator, class Compare>
+    inline bool is_sorted(ForwardIterator first, ForwardIterator last, Compare comp)
+    {
+        return MYSTL::is_sorted_until(first, last, comp) == last;
+    }
+
+    template<class ForwardIterator>
+    inline bool is_sorted(ForwardIterator first, ForwardIterator last)
+    {
+        return MYSTL::is_sorted_until(first, last, __iter_less()) == last;
+    }
 }
 
 #endif
@@ -38,8 +38,8 @@ struct __deque_iterator : public iterator<random_iterator_tag, T> {
     typedef T** map_pointer;
     typedef __deque_iterator self;
     typedef typename iterator<random_iterator_tag, T>::difference_type difference_type;
-    typedef typename iterator<random_iterator_tag, T>::reference reference;
-    typedef typename iterator<random_iterator_tag, T>::pointer  pointer;
+    typedef Ref reference;
+    typedef Ptr pointer;
 
     // 将Iterator与迭代器进行链接
     T*  cur;        // 该指针指向所指之缓冲区的现行元素
@@ -50,7 +50,8 @@ struct __deque_iterator : public iterator<random_iterator_tag, T> {
     // construct
     __deque_iterator(T* x, map_pointer y) noexcept : cur(x), frist(*y), last(frist + buffer_size()), node(y) { }
     __deque_iterator( ) noexcept : cur(), frist(), last(), node() { }
-    __deque_iterator(const self& x) noexcept : cur(x.cur), frist(x.frist), last(x.last), node(x.node) { } 
+    // 对 iterator 是复制构造，对 const_iterator 是由 iterator 转换
+    __deque_iterator(const __iterator& x) noexcept : cur(x.cur), frist(x.frist), last(x.last), node(x.node) { }
 
 public:
     /**
@@ -64,9 +65,9 @@ public:
     }
     reference operator*() const { return *cur; }
     pointer operator->() const { return &(operator*()); }
-    // 计算两个迭代器之间的距离
+    // 计算两个迭代器之间的距离，两个迭代器都为空(没有 map 的 deque)时距离为 0
     difference_type operator-(const self&x) const {
-        return ( buffer_size() ) * ( this->node - x.node - 1) + (this->cur - this->frist) + (x.last - x.cur);
+        return ( buffer_size() ) * ( this->node - x.node - difference_type(this->node != 0) ) + (this->cur - this->frist) + (x.last - x.cur);
     }
     // 后置与前置加法
     self& operator++() {
@@ -141,8 +142,12 @@ public:
     }
 };
 
-template <class T, class Alloc = simple_alloc<T, __default_alloc_template<0>>, size_t Bufsize = 0>
-class deque {
+/**
+ *  deque 继承自己的缓冲区配置器，从而持有一个 Alloc 对象，map 也从同一个 Alloc 对象配置
+ *  复制、移动、交换时按照 __alloc_traits<Alloc> 的规则处理配置器
+*/
+template <class T, class Alloc = __default_alloc_template<0>, size_t Bufsize = 0>
+class deque : protected simple_alloc<T, Alloc> {
 public:
     typedef T   value_type;
     typedef T*  pointer;
@@ -151,15 +156,18 @@ public:
     typedef const T& const_reference;
     typedef size_t  size_type;
     typedef ptrdiff_t   difference_type;
+    typedef Alloc       allocator_type;
 
     // deque iterator
     typedef __deque_iterator<T, T&, T*, Bufsize> iterator;
+    typedef typename iterator::__const_iterator const_iterator;
 
 protected:
     // 专属空间配置器, 每次配置一个元素大小
-    typedef simple_alloc<value_type, __default_alloc_template<0>> data_allocator;
-    // 专属空间配置器，每次配置一个指针大小
-    typedef simple_alloc<pointer, __default_alloc_template<0>> map_allocator;
+    typedef simple_alloc<value_type, Alloc> data_allocator;
+    // 专属空间配置器，每次配置一个指针大小，使用 data_allocator 持有的 Alloc 对象
+    typedef simple_alloc<pointer, Alloc> map_allocator;
+    typedef __alloc_traits<Alloc> alloc_traits;
 
     enum { initial_map_size = 8 };
 protected:
@@ -182,8 +190,40 @@ protected:
     pointer allocate_node() { return data_allocator::allocate( iterator::buffer_size()); }
     // 内存节点释放
     void deallocate_node(pointer p) { data_allocator::deallocate(p, iterator::buffer_size()); }
+    // 配置与释放 map
+    map_pointer allocate_map(size_type n) { return map_allocator(this->allocator()).allocate(n); }
+    void deallocate_map(map_pointer p, size_type n) { map_allocator(this->allocator()).deallocate(p, n); }
     // 重新分配map节点
     void reallocater_map(size_type nodes_to_add, bool add_at_front);
+    // 释放 [start.node, finish.node] 的缓冲区与 map，不析构元素，之后 deque 为没有 map 的空状态
+    void deallocate_map_and_nodes();
+    // 析构所有元素并释放所有缓冲区与map
+    void release();
+    // 接管 x 的 map 与缓冲区，x 成为没有 map 的空 deque，不配置任何空间
+    void steal(deque& x);
+    // *this 为刚释放的状态，按 x 的元素重新配置并复制
+    // 复制抛出异常时已构造的元素由 uninitialized_copy 析构，空间全部释放，*this 保持为空
+    void copy_initialize(const deque& x) {
+        create_map_and_nodes(x.size());
+        try {
+            uninitialized_copy(x.begin(), x.end(), start);
+        } catch(...) {
+            deallocate_map_and_nodes();
+            throw;
+        }
+    }
+
+    // *this 为刚释放的状态，按 x 的元素重新配置并逐个移动，x 变为空 deque；配置器不同、不能接管 x 的空间时使用
+    void move_initialize(deque& x) {
+        create_map_and_nodes(x.size());
+        try {
+            uninitialized_move(x.begin(), x.end(), start);
+        } catch(...) {
+            deallocate_map_and_nodes();
+            throw;
+        }
+        x.clear();
+    }
     
     // push_back只剩一个空间时调用
     void push_back_aux(const value_type& t);
@@ -225,10 +265,67 @@ public:
     {
         create_map_and_nodes(0);
     }
+
+    explicit deque(const Alloc& a) : data_allocator(a), start(), finish(), map(0), map_size(0)
+    {
+        create_map_and_nodes(0);
+    }
+
+    deque(const deque& x) : data_allocator(alloc_traits::select_on_copy_construction(x.allocator())),
+                            start(), finish(), map(0), map_size(0)
+    {
+        copy_initialize(x);
+    }
+
+    deque(const deque& x, const Alloc& a) : data_allocator(a), start(), finish(), map(0), map_size(0)
+    {
+        copy_initialize(x);
+    }
+
+    deque(deque&& x) noexcept : data_allocator(x.allocator()), start(), finish(), map(0), map_size(0)
+    {
+        steal(x);
+    }
+
+    ~deque() { release(); }
+
+    deque& operator=(const deque& x) {
+        if(this != &x) {
+            release();
+            __alloc_copy_assign(this->allocator(), x.allocator());
+            copy_initialize(x);
+        }
+        return *this;
+    }
+
+    deque& operator=(deque&& x) noexcept(__alloc_move_noexcept<Alloc>::value) {
+        if(this != &x) {
+            release();
+            if(__alloc_move_steals(this->allocator(), x.allocator())) {
+                __alloc_move_assign(this->allocator(), x.allocator());
+                steal(x);
+            } else {
+                move_initialize(x);
+            }
+        }
+        return *this;
+    }
+
+    void swap(deque& x) {
+        __alloc_swap(this->allocator(), x.allocator());
+        MYSTL::swap(start, x.start);
+        MYSTL::swap(finish, x.finish);
+        MYSTL::swap(map, x.map);
+        MYSTL::swap(map_size, x.map_size);
+    }
+
+    allocator_type get_allocator() const { return this->allocator(); }
 public:
     // basic access
     iterator begin() { return start; }
     iterator end() {  return finish; }
+    const_iterator begin() const { return start; }
+    const_iterator end() const {  return finish; }
 
     reference operator[] (size_type n) {
         // 调用__deque_iterator<>::operator[]
@@ -271,7 +368,7 @@ public:
 
     // 公共接口函数供调用
     void push_back(const value_type& t) {
-        if(finish.cur != finish.last - 1) {
+        if(finish.last - finish.cur > 1) {
             // 最后缓冲区有至少两个备用空间，则直接构造在上面
             construct(finish.cur, t);
             ++finish.cur;
@@ -337,7 +434,7 @@ void deque<T, Alloc, Bufsize>::create_map_and_nodes(size_type num_elements)
 
     // 前后各预留一个节点，最少配置节点数量为8个
     map_size = initial_map_size > (num_nodes + 2) ? initial_map_size : (num_nodes + 2);
-    map = map_allocator::allocate(map_size);
+    map = allocate_map(map_size);
     // 以上配置 map_size 个节点的map
 
     // 令指针合适得指向所有节点
@@ -349,8 +446,18 @@ void deque<T, Alloc, Bufsize>::create_map_and_nodes(size_type num_elements)
 
     // 为map的每个节点指向一个缓冲区，为每个节点配置缓冲区
     // map中所有节点加起来就是map的空间
-    for(cur = nstart; cur <= nfinish; ++cur)
-        *cur = allocate_node();
+    try {
+        for(cur = nstart; cur <= nfinish; ++cur)
+            *cur = allocate_node();
+    } catch(...) {
+        // 配置失败，释放已配置的缓冲区与 map
+        for(map_pointer n = nstart; n < cur; ++n)
+            deallocate_node(*n);
+        deallocate_map(map, map_size);
+        map = 0;
+        map_size = 0;
+        throw;
+    }
 
     // 设置deque迭代器
     start.set_node(nstart);
@@ -362,6 +469,12 @@ void deque<T, Alloc, Bufsize>::create_map_and_nodes(size_type num_elements)
 // 只有当尾部只剩一个剩余空间时才会调用该函数 finish.cur == finish.last -1
 template <class T, class Alloc, size_t Bufsize>
 void deque<T, Alloc, Bufsize>::push_back_aux(const value_type& t) {
+    if(map == 0) {
+        // 没有 map 的空 deque，先配置 map 与一个缓冲区
+        create_map_and_nodes(0);
+        push_back(t);
+        return;
+    }
     value_type copy = t;
     // 若满足某种条件重新换一个map
     reserve_map_at_back();
@@ -383,6 +496,11 @@ void deque<T, Alloc, Bufsize>::push_back_aux(const value_type& t) {
 // 只有当前部没有剩余空间时才会调用该函数
 template <class T, class Alloc, size_t Bufsize>
 void deque<T, Alloc, Bufsize>::push_front_aux(const value_type& t) {
+    if(map == 0) {
+        create_map_and_nodes(0);
+        push_front(t);
+        return;
+    }
     value_type copy = t;
     // 若满足某种条件重新换一个map
     reserve_map_at_front();
@@ -439,12 +557,12 @@ void deque<T, Alloc, Bufsize>::reallocater_map(size_type node_to_add, bool add_a
         // 原map没有足够的大小，需要重新分配一个更大的map
         size_type new_map_size = map_size + (map_size > node_to_add ? map_size : node_to_add) + 2;
         // 配置一块空间，准备给新map
-        map_pointer new_map = map_allocator::allocate(new_map_size);
+        map_pointer new_map = allocate_map(new_map_size);
         new_start = new_map + (new_map_size - new_num_nodes) / 2 + (add_at_front ? node_to_add : 0);
         // 拷贝原map内容
-        MYSTL::copy(start.node, finish.node, new_start);
+        MYSTL::copy(start.node, finish.node + 1, new_start);
         // 释放原map
-        map_allocator::deallocate(map, map_size);
+        deallocate_map(map, map_size);
         // 设置新map大小和指针
         map = new_map;
         map_size = new_map_size;
@@ -454,12 +572,41 @@ void deque<T, Alloc, Bufsize>::reallocater_map(size_type node_to_add, bool add_a
     finish.set_node(new_start + old_num_nodes - 1);
 }
 
+template <class T, class Alloc, size_t Bufsize>
+void deque<T, Alloc, Bufsize>::deallocate_map_and_nodes() {
+    for(map_pointer node = start.node; node <= finish.node; ++node)
+        deallocate_node(*node);
+    deallocate_map(map, map_size);
+    map = 0;
+    map_size = 0;
+    start = finish = iterator();
+}
+
+template <class T, class Alloc, size_t Bufsize>
+void deque<T, Alloc, Bufsize>::release() {
+    if(map == 0) return;
+    destroy(start, finish);
+    deallocate_map_and_nodes();
+}
+
+template <class T, class Alloc, size_t Bufsize>
+void deque<T, Alloc, Bufsize>::steal(deque& x) {
+    start = x.start;
+    finish = x.finish;
+    map = x.map;
+    map_size = x.map_size;
+    x.map = 0;
+    x.map_size = 0;
+    x.start = x.finish = iterator();
+}
+
 // 清空队列
 /**
  *   用来清空整个队列，但会保留一个缓冲区
 */
 template <class T, class Alloc, size_t Bufsize>
 void deque<T, Alloc, Bufsize>::clear() {
+    if(map == 0) return;
     // 头尾的迭代器一定是满元素，则全部回收
     for(map_pointer node = start.node + 1; node < finish.node; ++node)
     {
@@ -470,14 +617,15 @@ void deque<T, Alloc, Bufsize>::clear() {
     }
     
     // 检查头尾迭代器是否是一个
+    // 头缓冲区中只有 [start.cur, start.last) 、尾缓冲区中只有 [finish.frist, finish.cur) 是构造过的元素
     if(start.node != finish.node) {
         // 头尾缓冲器不为同一个则分别释放头尾迭代器中内存
-        destroy(start.frist, start.last);
-        destroy(finish.frist, finish.last);
+        destroy(start.cur, start.last);
+        destroy(finish.frist, finish.cur);
         // 释放尾部迭代器缓冲区，保留头缓冲区
         data_allocator::deallocate(*finish.node, iterator::buffer_size());
     }else {
-        destroy(start.frist, start.last);
+        destroy(start.cur, finish.cur);
     }
     // 调整尾部迭代器
     finish = start;
@@ -491,10 +639,10 @@ typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::erase(iter
     difference_type index = pos - start;
     if(index < (size() >> 1) ) {
         // 移动元素小于一般，则移动前面元素
-        copy_backward(start, pos, next);
+        MYSTL::move_backward(start, pos, next);
         pop_front();
     }else {
-        copy(next, finish, pos);
+        MYSTL::move(next, finish, pos);
         pop_back();
     }
     return start + index;
@@ -503,6 +651,9 @@ typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::erase(iter
 // 清除[first, last)所指元素
 template<class T, class Alloc, size_t BufSize>
 typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::erase(iterator first, iterator last) {
+    // 空区间直接返回，避免元素移动赋值给自己
+    if(first == last)
+        return first;
     // 如果清除整个区域则调用clear
     if(first == start && last == finish) {
         clear();
@@ -511,7 +662,7 @@ typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::erase(iter
         difference_type n = last - first;   // 需要清除的缓冲区长度
         difference_type elems_before = first - start;   // 清楚起始开头位置
         if( elems_before < (size() - n) / 2) {
-            MYSTL::copy_backward(start, first, last);
+            MYSTL::move_backward(start, first, last);
             iterator new_start = start + n;
             destroy(start, first);
             // 将map缓冲区回收
@@ -519,7 +670,7 @@ typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::erase(iter
                 data_allocator::deallocate(*cur, iterator::buffer_size());
             start = new_start;
         } else {    // 需要清除区域后后方元素较少
-            MYSTL::copy(last, finish, first);
+            MYSTL::move(last, finish, first);
             iterator new_finish = finish - n;
             destroy(new_finish, finish);
             // 将map缓冲区回收
@@ -537,7 +688,7 @@ typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::insert_aux
     difference_type index = position - start;   //插入点之前的个数
     value_type x_copy = x;
     if(index < (size() >> 1)) { // 插入点之前元素较少，移动先前元素
-        push_back(front());     // 最前端加入一个与队头相同元素
+        push_front(front());    // 最前端加入一个与队头相同元素
         iterator front1 = start;
         ++front1;
         iterator front2 = front1;
@@ -545,7 +696,7 @@ typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::insert_aux
         position = start + index;
         iterator pos = position;
         ++pos;
-        copy(front2, pos, front1); 
+        MYSTL::move(front2, pos, front1);
     }else { // 插入点之后元素较少，移动后面的元素
         push_back(back());
         iterator back1 = finish;
@@ -553,9 +704,9 @@ typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::insert_aux
         iterator back2 = back1;
         --back2;
         position = start + index;
-        copy_backward(position, back2, back1);
+        MYSTL::move_backward(position, back2, back1);
     }
-    *position = x_copy;
+    *position = std::move(x_copy);
     return position;
 }
 
@@ -1,12 +1,14 @@
 #ifndef __STL_HEAP_H
 #define __STL_HEAP_H
 
+#include <utility>
 #include "stl_iterator.h"
 
 /**
  *      堆算法，堆算法的底层容器要求为RandmoAccessIterator迭代器，且内存要是可变化的内存，
  *      堆算法底层迭代器最好选用Vector<>容器
  *      且使用大根堆，堆头为堆最大元素值
+ *      元素类型与距离类型通过 iterator_traits 取得，调整堆时移动元素而不是复制
 */
 
 /**
@@ -20,25 +22,27 @@ void __push_heap(RandomAccessIterator first, Distance holeIndex, Distance topInd
     // 一直循环调整堆，父节点值小于value则父节点下方
     while(holeIndex > topIndex && cmp(*(first + parent), value) ) {
         // 堆没有循环完成且当前节点小于value,需要将当前节点下方
-        *(first + holeIndex) = *(first + parent);
+        *(first + holeIndex) = std::move(*(first + parent));
         // 继续向上调整
         holeIndex = parent;
         parent = (holeIndex - 1) / 2;
     }
     // 循环完成最后的holeIndex位置就是value在堆中位置
-    *(first + holeIndex) = value;
+    *(first + holeIndex) = std::move(value);
 }
 
 template<class RandomAccessItera, class Distance, class T, class Compare>
-inline void __push_heap_aux(RandomAccessItera first, RandomAccessItera last, Distance, T, Compare cmp) {
+inline void __push_heap_aux(RandomAccessItera first, RandomAccessItera last, Distance*, T*, Compare cmp) {
     // 再处理后转交一层工作
-    __push_heap(first, Distance((last - first) - 1), Distance(0), T(*(last - 1)), cmp);
+    ::__push_heap(first, Distance((last - first) - 1), Distance(0), T(std::move(*(last - 1))), cmp);
 }
 
 template <class RandomAccessIterator, class Compare>
 inline void push_heap(RandomAccessIterator first, RandomAccessIterator last, Compare cmp) {
     // 且需要加入的堆的元素已经被压入堆中，真正的工作交给aux底层函数
-    __push_heap_aux(first, last, distance_type(first), value_type(first), cmp);
+    typedef typename iterator_traits<RandomAccessIterator>::difference_type Distance;
+    typedef typename iterator_traits<RandomAccessIterator>::value_type T;
+    ::__push_heap_aux(first, last, (Distance*)0, (T*)0, cmp);
 }
 
 /**
@@ -55,7 +59,7 @@ void __adjust_heap(RandomAccessIterator first, Distance holdIndex, Distance len,
         if( cmp( *(first + secondChild), *(first + secondChild - 1) ) )
             --secondChild;
 
-        *(first + holdIndex) = *(first + secondChild);
+        *(first + holdIndex) = std::move(*(first + secondChild));
         // 调整holdIndex继续循环
         holdIndex = secondChild;
         secondChild = (holdIndex + 1) * 2; 
@@ -63,29 +67,31 @@ void __adjust_heap(RandomAccessIterator first, Distance holdIndex, Distance len,
     // 堆有节点没有右孩子，则让左节点向上调整
     if(secondChild == len){
         --secondChild;
-        *(first + holdIndex) = *(first + secondChild);
+        *(first + holdIndex) = std::move(*(first + secondChild));
         holdIndex = secondChild;
     }
     // 此时可能没有满足堆的规则，则调整一次堆
-    __push_heap(first, holdIndex, topIndex, value, cmp);
+    ::__push_heap(first, holdIndex, topIndex, std::move(value), cmp);
 }
 
 template<class RandomAccessIterator, class Distance, class T, class Compare>
-inline void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, RandomAccessIterator result, T value, Distance, Compare cmp) {
+inline void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, RandomAccessIterator result, T value, Distance*, Compare cmp) {
     // 将堆头值设置为尾部值
-    *result = *first;
+    *result = std::move(*first);
     // 调整堆尾值
-    __adjust_heap(first, Distance(0), Distance(last - first), value, cmp);
+    ::__adjust_heap(first, Distance(0), Distance(last - first), std::move(value), cmp);
 }
 
 template<class RandomAccessIterator, class T, class Compare>
-inline void __pop_heap_aux(RandomAccessIterator first, RandomAccessIterator last, T, Compare cmp) {
-    __pop_heap(first, last -1, last -1, T(*(last -1)), distance_type(first), cmp);
+inline void __pop_heap_aux(RandomAccessIterator first, RandomAccessIterator last, T*, Compare cmp) {
+    typedef typename iterator_traits<RandomAccessIterator>::difference_type Distance;
+    ::__pop_heap(first, last -1, last -1, T(std::move(*(last -1))), (Distance*)0, cmp);
 }
 
 template<class RandomAccessIterator, class Compare>
 inline void pop_heap(RandomAccessIterator first, RandomAccessIterator last, Compare cmp) {
-    __pop_heap_aux(first, last, value_type(first), cmp);
+    typedef typename iterator_traits<RandomAccessIterator>::value_type T;
+    ::__pop_heap_aux(first, last, (T*)0, cmp);
 }
 
 
@@ -98,7 +104,7 @@ void sort_heap(RandomAccessIterator first, RandomAccessIterator last, Compare cm
     // 每次执行pop_heap操作，堆中极值就被放在堆尾，则减少堆元素在执行一次pop_heao，知道堆中只剩下一个元素
     // 但执行完成后堆的规则被破坏，原容器就不在是一个堆
     while(last - first > 1)
-        pop_heap(first, last--, cmp);   // 执行一次pop_heap，堆的范围就减小一
+        ::pop_heap(first, last--, cmp);   // 执行一次pop_heap，堆的范围就减小一
 }
 
 
@@ -106,14 +112,14 @@ void sort_heap(RandomAccessIterator first, RandomAccessIterator last, Compare cm
  *  make_heap算法系列，将迭代器[first, last)排列成一个heap
 */
 template<class RandomAccessIterator, class T, class Distance, class Compare>
-void __make_heap(RandomAccessIterator first, RandomAccessIterator last, T, Distance, Compare cmp) {
+void __make_heap(RandomAccessIterator first, RandomAccessIterator last, T*, Distance*, Compare cmp) {
     if(last - first < 2) return;    // 堆长度小于2则直接返回
     // 由于叶节点不需要重新排列，则找出第一个不为的子树，进行重新排序，然后从下到上进行重新调整，最后就是一个堆
     Distance len = last - first;
     Distance holdIndex = (len - 2) / 2;
     while(true) {
         // 重排holdIndex为根节点的子树
-        __adjust_heap(first, holdIndex, len, T(*(first + holdIndex)), cmp);
+        ::__adjust_heap(first, holdIndex, len, T(std::move(*(first + holdIndex))), cmp);
         if(holdIndex == 0) return;
         holdIndex--;
     }
@@ -121,7 +127,9 @@ void __make_heap(RandomAccessIterator first, RandomAccessIterator last, T, Dista
 
 template<class RandomAccessIterator, class Compare>
 inline void make_heap(RandomAccessIterator first, RandomAccessIterator last, Compare cmp) {
-    __make_heap(first, last, value_type(first), distance_type(first), cmp);
+    typedef typename iterator_traits<RandomAccessIterator>::difference_type Distance;
+    typedef typename iterator_traits<RandomAccessIterator>::value_type T;
+    ::__make_heap(first, last, (T*)0, (Distance*)0, cmp);
 }
 
 #endif
@@ -70,9 +70,10 @@ struct __list_iterator {
 /**
  *  list 通过 list_iterator进行操作
  *  为了满足iterator迭代器的要求（对数组元素实行左开右闭区间），则令list指向一个node节点，该节点为空
+ *  list 继承自己的节点配置器，从而持有一个 Alloc 对象，复制、移动、交换时按照 __alloc_traits<Alloc> 的规则处理配置器
 */
 template <class T, class Alloc = __default_alloc_template<0>>
-class list 
+class list : protected simple_alloc<__list_node<T>, Alloc>
 {
 protected:
     typedef __list_node<T> list_node;
@@ -87,10 +88,14 @@ public:
     typedef __list_iterator<T, T&, T*> iterator;
     typedef size_t      size_type;
     typedef ptrdiff_t   difference_type;
+    typedef Alloc       allocator_type;
 
 protected:
     link_type node;     // 指向一个list_node
     typedef simple_alloc<list_node, Alloc> list__node_allocator;
+    typedef __alloc_traits<Alloc> alloc_traits;
+    typedef __node_batch<list_node, Alloc> node_batch;
+    typedef __node_release<list_node, Alloc> node_release;
 
 protected:
     // 配置一个节点空间
@@ -104,12 +109,37 @@ protected:
         return p;
     }
 
+    // 从 batch 中取出节点并以 x 构造(x 为右值时移动)，用于区间插入
+    template<class V>
+    link_type create_node(node_batch& batch, V&& x) {
+        link_type p = batch.get();
+        try {
+            construct(&p->data, std::forward<V>(x));
+        } catch(...) {
+            batch.put(p);
+            throw;
+        }
+        return p;
+    }
+
+    // 将节点 tmp 接到 position 之前
+    void link_node(iterator position, link_type tmp) {
+        tmp->next = position.node;
+        tmp->prev = position.node->prev;
+        (link_type(position.node->prev))->next = tmp;
+        position.node->prev = tmp;
+    }
+
     // 销毁一个节点
     void destroy_node(link_type p) {
         destroy(&p->data);
         put_node(p);
     }
 
+    // 析构并归还 node 之外的全部节点，不修改 node 的指针
+    void release_nodes(__true_type) { }     // 节点空间由配置器整体回收，不需要遍历
+    void release_nodes(__false_type);
+
 protected:
     void empty_initialize() {
         node = get_node();
@@ -131,14 +161,36 @@ protected:
         }
     }
 
+    template<class Integer>
+    void insert_dispatch(iterator position, Integer n, Integer x, __true_type) { insert(position, (size_type)n, (T)x); }
+    template<class InputIterator>
+    void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type);
+
+    // 复制 x 的所有元素到 *this 的尾部
+    void copy_elements(const list& x) {
+        insert(end(), x.begin(), x.end());
+    }
+
+    // 逐个移动 x 的元素到 *this 的尾部，x 变为空 list；配置器不同、不能接管 x 的节点时使用
+    void move_elements(list& x) {
+        node_batch batch(*this, x.size());
+        for(iterator i = x.begin(); i != x.end(); ++i)
+            link_node(end(), create_node(batch, std::move(*i)));
+        x.clear();
+    }
+
+public:
     // 与链表x交换数据
     void swap(list& x) 
     {
-        list_node tmp = node;
+        __alloc_swap(this->allocator(), x.allocator());
+        link_type tmp = node;
         node = x.node;
-        x.node = node;
+        x.node = tmp;
     }
 
+    allocator_type get_allocator() const { return this->allocator(); }
+
 public:
     iterator begin() const { return iterator((link_type)((*node).next)); }
     iterator end()  const { return iterator(node); }
@@ -147,7 +199,7 @@ public:
 
     size_type size() const 
     {
-        return distance(begin(), end());
+        return ::distance(begin(), end());
     }
 
     reference front() { return *begin(); }
@@ -158,13 +210,22 @@ public:
         // 产生一个节点
         link_type tmp = create_node(x);
         // 调整指针加入节点
-        tmp->next = position.node;
-        tmp->prev = position.node->prev;
-        (link_type(position.node->prev))->next = tmp;
-        position.node->prev = tmp;
+        link_node(position, tmp);
         return iterator(tmp);
     }
 
+    // 将 [first, last) 插入 position 之前，节点成批配置；整数类型的"区间"是 n 个 x
+    template<class InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        insert_dispatch(position, first, last, is_integer());
+    }
+
+    // 在 position 之前插入 n 个 x
+    void insert(iterator position, size_type n, const T& x);
+    void insert(iterator position, int n, const T& x) { insert(position, (size_type)n, x); }
+    void insert(iterator position, long n, const T& x) { insert(position, (size_type)n, x); }
+
     void push_back(const T& x) { insert(end(), x); }
     void push_front(const T& x) { insert(begin(), x); }
 
@@ -186,6 +247,75 @@ public:
 
     // construct
     list() { empty_initialize(); }      // 产生一个空链表
+    explicit list(const Alloc& a) : list__node_allocator(a) { empty_initialize(); }
+
+    list(size_type n, const T& value, const Alloc& a = Alloc()) : list__node_allocator(a) {
+        empty_initialize();
+        insert(end(), n, value);
+    }
+    list(int n, const T& value, const Alloc& a = Alloc()) : list__node_allocator(a) {
+        empty_initialize();
+        insert(end(), (size_type)n, value);
+    }
+    list(long n, const T& value, const Alloc& a = Alloc()) : list__node_allocator(a) {
+        empty_initialize();
+        insert(end(), (size_type)n, value);
+    }
+
+    template<class InputIterator>
+    list(InputIterator first, InputIterator last, const Alloc& a = Alloc()) : list__node_allocator(a) {
+        empty_initialize();
+        insert(end(), first, last);
+    }
+
+    list(const list& x) : list__node_allocator(alloc_traits::select_on_copy_construction(x.allocator())) {
+        empty_initialize();
+        copy_elements(x);
+    }
+
+    list(const list& x, const Alloc& a) : list__node_allocator(a) {
+        empty_initialize();
+        copy_elements(x);
+    }
+
+    // 移动构造，把 x 的全部节点接到 *this 上
+    list(list&& x) : list__node_allocator(x.allocator()) {
+        empty_initialize();
+        splice(end(), x);
+    }
+
+    ~list() {
+        clear();
+        put_node(node);
+    }
+
+    list& operator=(const list& x) {
+        if(this != &x) {
+            clear();
+            if(__alloc_copy_changes(this->allocator(), x.allocator())) {
+                // 空 node 也要交还给原来的配置器
+                put_node(node);
+                __alloc_copy_assign(this->allocator(), x.allocator());
+                empty_initialize();
+            }
+            copy_elements(x);
+        }
+        return *this;
+    }
+
+    list& operator=(list&& x) noexcept(__alloc_move_noexcept<Alloc>::value) {
+        if(this != &x) {
+            clear();
+            if(__alloc_move_steals(this->allocator(), x.allocator())) {
+                // 交换 node 与配置器，原来的空 node 随 x 一起由原来的配置器释放
+                __alloc_swap(this->allocator(), x.allocator(), __true_type());
+                MYSTL::swap(node, x.node);
+            } else {
+                move_elements(x);
+            }
+        }
+        return *this;
+    }
 
     // 各种split接口
     // 将x接合与position所指位置之前
@@ -220,6 +350,21 @@ public:
     void sort();
 };
 
+template<class T, class Alloc>
+template<class InputIterator>
+void list<T, Alloc>::insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type) {
+    node_batch batch(*this, __batch_hint(first, last));
+    for(; first != last; ++first)
+        link_node(position, create_node(batch, *first));
+}
+
+template<class T, class Alloc>
+void list<T, Alloc>::insert(iterator position, size_type n, const T& x) {
+    node_batch batch(*this, n);
+    for(; n > 0; --n)
+        link_node(position, create_node(batch, x));
+}
+
 template<class T, class Alloc>
 typename list<T,Alloc>::iterator list<T, Alloc>::erase(iterator position) {
     link_type next_node = link_type(position.node->next);
@@ -231,13 +376,20 @@ typename list<T,Alloc>::iterator list<T, Alloc>::erase(iterator position) {
 }
 
 template<class T, class Alloc>
-void list<T, Alloc>::clear() {
+void list<T, Alloc>::release_nodes(__false_type) {
+    node_release released(*this);
     link_type cur = (link_type)node->next;
     while(cur != node) {
         link_type tmp = cur;
         cur = (link_type)cur->next;
-        destroy_node(tmp);
+        destroy(&tmp->data);
+        released.put(tmp);
     }
+}
+
+template<class T, class Alloc>
+void list<T, Alloc>::clear() {
+    release_nodes(typename __node_teardown<T, Alloc>::skip());
     // 恢复只有一个空node的list初始状态
     node->next = node;
     node->prev = node;
@@ -315,27 +467,45 @@ void list<T, Alloc>::sort() {
     // 空list或者只有一个元素则直接返回
     if(node->next == node || link_type(node->next)->next == node) return;
 
-    // 临时list用于临时存放数据
-    list<T, Alloc> carry;           // 每次取原list头元素放到
-    list<T, Alloc> bucket[64];     // 64个桶，每个桶的大小为2^i
+    // 临时list用于临时存放数据，与本 list 使用同一个配置器(有状态的配置器可能没有可用的默认值)
+    list<T, Alloc> carry(this->allocator());    // 每次取原list头元素放到
+    // 64个桶，每个桶的大小为2^i；桶用到时才以本 list 的配置器构造
+    typedef typename std::aligned_storage<sizeof(list<T, Alloc>), alignof(list<T, Alloc>)>::type bucket_storage;
+    bucket_storage storage[64];
+    list<T, Alloc>* bucket = reinterpret_cast<list<T, Alloc>*>(storage);
     int fill = 0;
-    while(!empty()) {
-        carry.splice(carry.begin(), *this, begin());    // 取出原list头元素
-        int i = 0;
-        // i < fill 的桶未满，不断向桶中运输元素，并保持桶中元素递增排序
-        // i < fill 的桶元素满， 归并所有桶中元素并放入容量更大的桶中.
-        while(i < fill && !bucket[i].empty() ) {
-            carry.merge(bucket[i]);
-            ++i;
+    try {
+        while(!empty()) {
+            carry.splice(carry.begin(), *this, begin());    // 取出原list头元素
+            int i = 0;
+            // i < fill 的桶未满，不断向桶中运输元素，并保持桶中元素递增排序
+            // i < fill 的桶元素满， 归并所有桶中元素并放入容量更大的桶中.
+            while(i < fill && !bucket[i].empty() ) {
+                carry.merge(bucket[i]);
+                ++i;
+            }
+            // bucket[fill]已满，增加下一个桶
+            if(i == fill) {
+                construct(bucket + fill, this->allocator());
+                ++fill;
+            }
+            bucket[i].swap(carry);
+        }
+        // 归并所有桶
+        for(int i = 1; i < fill; i++)
+            bucket[i].merge(bucket[i - 1]);
+    } catch(...) {
+        // 比较抛出异常，把所有节点接回本 list(不保证有序)，再析构已构造的桶
+        splice(end(), carry);
+        for(int i = 0; i < fill; ++i) {
+            splice(end(), bucket[i]);
+            destroy(bucket + i);
         }
-        bucket[i].swap(carry);
-        // bucket[fill]已满，增加下一个桶
-        if(i == fill) ++fill;
-    }
-    // 归并所有桶
-    for(int i = 1; i < fill; i++)
-        bucket[i].merge(bucket[i - 1]);
-    swap(bucket[fill - 1]);
+        throw;
+    }
+    splice(end(), bucket[fill - 1]);
+    for(int i = 0; i < fill; ++i)
+        destroy(bucket + i);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+#ifndef _MMAP_VECTOR_H
+#define _MMAP_VECTOR_H
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "vector.h"
+
+/**
+ *  以文件映射为存储空间的 vector，接口与 vector 相同，元素类型必须可以按位复制
+ *  文件的内容就是元素数组本身，没有额外的文件头，可以直接打开已有的数据文件：
+ *      open() 只建立映射，不读取文件，页面在第一次访问时才由系统载入，不占用匿名内存，
+ *      内存紧张时干净的页面可以直接丢弃，脏页写回文件
+ *      容量不够时先通过 ftruncate 扩大文件，再通过 mremap 扩大映射(没有 mremap 时重新映射)，
+ *      元素留在页缓存中，不需要复制，也不会出现新旧两份空间同时存在的情况
+ *      使用中文件长度为容量，close() 或析构时截断为 size() 个元素；sync() 把修改写回文件
+ *  以 read_only 打开时映射为只读，不能修改元素，也不能改变大小
+ *  扩大文件或映射失败时与配置器一样按 out of memory 处理
+ *  mmap_vector 独占文件描述符与映射，只能移动不能复制
+*/
+template <class T, class Growth = vector_growth_double>
+class mmap_vector {
+    static_assert(std::is_trivially_copyable<T>::value, "mmap_vector requires a trivially copyable type");
+public:
+    using value_type = T;
+    using iterator   = T*;
+    using const_iterator = const T*;
+    using pointer    = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using growth_policy = Growth;
+
+    // 打开方式：只读；读写，文件不存在时创建；读写并清空原有内容
+    enum open_mode { read_only, read_write, truncate };
+
+protected:
+    int fd;
+    bool writable;
+    iterator start;
+    iterator finish;
+    iterator end_of_storage;
+
+    // 把文件与映射都调整为 n 个元素，元素留在原来的文件位置上
+    void remap(size_type n);
+
+    void reserve_more(size_type n) {
+        if(size_type(end_of_storage - finish) < n)
+            remap(Growth::grow(size(), n));
+    }
+
+    void reset() {
+        fd = -1;
+        writable = false;
+        start = finish = end_of_storage = nullptr;
+    }
+
+    void steal(mmap_vector& x) {
+        fd = x.fd;
+        writable = x.writable;
+        start = x.start;
+        finish = x.finish;
+        end_of_storage = x.end_of_storage;
+        x.reset();
+    }
+
+    // 在 position 处空出 n 个元素的位置，返回新的 position
+    iterator open_gap(iterator position, size_type n) {
+        const size_type index = position - start;
+        reserve_more(n);
+        position = start + index;
+        memmove(position + n, position, (finish - position) * sizeof(T));
+        finish += n;
+        return position;
+    }
+
+    template <class Integer>
+    void insert_dispatch(iterator position, Integer n, Integer x, __true_type) { insert(position, (size_type)n, (T)x); }
+    template <class InputIterator>
+    void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+    { range_insert(position, first, last, iterator_category(first)); }
+
+    template <class InputIterator>
+    void range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag) {
+        for(; first != last; ++first, ++position)
+            position = insert(position, *first);
+    }
+    template <class ForwardIterator>
+    void range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+        const size_type n = ::distance(first, last);
+        if(0 == n) return;
+        position = open_gap(position, n);
+        for(; first != last; ++first, ++position)
+            *position = *first;
+    }
+
+public:
+    mmap_vector() { reset(); }
+    mmap_vector(const char * path, open_mode mode = read_write) { reset(); open(path, mode); }
+    mmap_vector(mmap_vector&& x) { steal(x); }
+    ~mmap_vector() { close(); }
+
+    mmap_vector& operator=(mmap_vector&& x) {
+        if(this != &x) {
+            close();
+            steal(x);
+        }
+        return *this;
+    }
+
+    // 打开 path，已有的内容成为元素；失败或文件长度不是元素大小的整数倍时返回 false
+    bool open(const char * path, open_mode mode = read_write);
+    // 截断多余的容量并关闭文件，截断失败时返回 false
+    bool close();
+    bool is_open() const { return fd >= 0; }
+
+    // 把 [begin(), end()) 的修改同步写回文件，失败时返回 false
+    bool sync() {
+        if(!writable || start == finish) return true;
+        return 0 == msync(start, (finish - start) * sizeof(T), MS_SYNC);
+    }
+
+    iterator begin() { return start; }
+    iterator end()   { return finish; }
+    const_iterator begin() const { return start; }
+    const_iterator end() const { return finish; }
+
+    size_type size() const { return size_type(finish - start); }
+    size_type capacity() const { return size_type(end_of_storage - start); }
+    bool empty() const { return start == finish; }
+
+    reference operator[](size_type n) { return start[n]; }
+    const_reference operator[](size_type n) const { return start[n]; }
+
+    reference front() { return *start; }
+    const_reference front() const { return *start; }
+    reference back() { return *(finish - 1); }
+    const_reference back() const { return *(finish - 1); }
+
+    pointer data() { return start; }
+    const_pointer data() const { return start; }
+
+    void push_back(const T& x) {
+        if(finish == end_of_storage) {
+            // x 可能就是文件中的元素，remap 之后会失效
+            T x_copy = x;
+            reserve_more(1);
+            *finish++ = x_copy;
+        } else {
+            *finish++ = x;
+        }
+    }
+
+    template <class... Args>
+    reference emplace_back(Args&&... args) {
+        T tmp(std::forward<Args>(args)...);
+        push_back(tmp);
+        return back();
+    }
+
+    void pop_back() { --finish; }
+
+    iterator insert(iterator position, const T& x) {
+        T x_copy = x;
+        position = open_gap(position, 1);
+        *position = x_copy;
+        return position;
+    }
+
+    void insert(iterator position, size_type n, const T& x) {
+        if(0 == n) return;
+        T x_copy = x;
+        position = open_gap(position, n);
+        for(iterator last = position + n; position != last; ++position)
+            *position = x_copy;
+    }
+
+    template <class InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        insert_dispatch(position, first, last, is_integer());
+    }
+
+    template <class InputIterator>
+    void append_range(InputIterator first, InputIterator last) { insert(end(), first, last); }
+    template <class Range>
+    void append_range(const Range& r) { insert(end(), r.begin(), r.end()); }
+
+    iterator erase(iterator first, iterator last) {
+        memmove(first, last, (finish - last) * sizeof(T));
+        finish -= (last - first);
+        return first;
+    }
+
+    iterator erase(iterator position) { return erase(position, position + 1); }
+
+    void resize(size_type new_size, const T& x) {
+        if(new_size < size())
+            finish = start + new_size;
+        else
+            insert(end(), new_size - size(), x);
+    }
+    void resize(size_type new_size) { resize(new_size, T()); }
+
+    // 新增的元素不初始化，文件新扩大的部分读出来为 0
+    void resize_uninitialized(size_type new_size) {
+        if(new_size > size())
+            reserve_more(new_size - size());
+        finish = start + new_size;
+    }
+
+    void reserve(size_type n) {
+        if(capacity() < n)
+            remap(n);
+    }
+
+    void shrink_to_fit() {
+        if(capacity() != size())
+            remap(size());
+    }
+
+    void clear() { finish = start; }
+
+    void assign(size_type n, const T& x) {
+        clear();
+        insert(end(), n, x);
+    }
+    template <class InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        clear();
+        insert(end(), first, last);
+    }
+
+    void swap(mmap_vector& x) {
+        MYSTL::swap(fd, x.fd);
+        MYSTL::swap(writable, x.writable);
+        MYSTL::swap(start, x.start);
+        MYSTL::swap(finish, x.finish);
+        MYSTL::swap(end_of_storage, x.end_of_storage);
+    }
+
+private:
+    mmap_vector(const mmap_vector&);
+    mmap_vector& operator=(const mmap_vector&);
+};
+
+template <class T, class Growth>
+bool mmap_vector<T, Growth>::open(const char * path, open_mode mode) {
+    close();
+    int flags = read_only == mode ? O_RDONLY : (O_RDWR | O_CREAT);
+    if(truncate == mode) flags |= O_TRUNC;
+    int f = ::open(path, flags, 0644);
+    if(f < 0) return false;
+
+    struct stat st;
+    if(0 != fstat(f, &st) || 0 != st.st_size % sizeof(T)) {
+        ::close(f);
+        return false;
+    }
+    const size_type n = st.st_size / sizeof(T);
+    T * p = nullptr;
+    if(n) {
+        int prot = read_only == mode ? PROT_READ : (PROT_READ | PROT_WRITE);
+        void * m = mmap(0, n * sizeof(T), prot, MAP_SHARED, f, 0);
+        if(MAP_FAILED == m) {
+            ::close(f);
+            return false;
+        }
+        p = (T *)m;
+    }
+    fd = f;
+    writable = read_only != mode;
+    start = p;
+    finish = end_of_storage = p + n;
+    return true;
+}
+
+template <class T, class Growth>
+bool mmap_vector<T, Growth>::close() {
+    if(fd < 0) return true;
+    bool ok = true;
+    if(start)
+        munmap(start, capacity() * sizeof(T));
+    // 去掉未使用的容量，文件中只留下元素
+    if(writable)
+        ok = 0 == ftruncate(fd, size() * sizeof(T));
+    ::close(fd);
+    reset();
+    return ok;
+}
+
+template <class T, class Growth>
+void mmap_vector<T, Growth>::remap(size_type n) {
+    assert(writable && "mmap_vector opened read_only cannot change its capacity");
+    const size_type old_size = size();
+    const size_type old_bytes = capacity() * sizeof(T);
+    const size_type bytes = n * sizeof(T);
+    // 增长时先扩大文件再扩大映射，缩小时反过来，映射始终不超出文件末尾
+    if(bytes > old_bytes && 0 != ftruncate(fd, bytes)) { __THROW_BAD_ALLOC; }
+
+    void * p = start;
+    if(0 == bytes) {
+        munmap(start, old_bytes);
+        p = nullptr;
+    } else if(0 == old_bytes) {
+        p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    } else {
+#ifdef MREMAP_MAYMOVE
+        p = mremap(start, old_bytes, bytes, MREMAP_MAYMOVE);
+#else
+        // 元素都在文件中，重新映射即可
+        munmap(start, old_bytes);
+        p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+    }
+    if(MAP_FAILED == p) { __THROW_BAD_ALLOC; }
+
+    if(bytes < old_bytes && 0 != ftruncate(fd, bytes)) { __THROW_BAD_ALLOC; }
+    start = (T *)p;
+    finish = start + (old_size < n ? old_size : n);
+    end_of_storage = start + n;
+}
+
+#endif
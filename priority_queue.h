@@ -30,12 +30,12 @@ public:
 
     template<class InputIterator>
     priority_queue(InputIterator first, InputIterator last, const Compare& x) : c(first, last), comp(x) {
-        make_heap(first, last, comp);
+        ::make_heap(first, last, comp);
     }
 
     template<class InputIterator>
     priority_queue(InputIterator first, InputIterator last) : c(first, last), comp() {
-        make_heap(c.begin(), c.end(), comp);
+        ::make_heap(c.begin(), c.end(), comp);
     }
 
     // priority 接口函数
@@ -46,11 +46,11 @@ public:
 
     void push(const value_type& x) {
         c.push_back(x);
-        push_heap(c.begin(), c.end(), comp);
+        ::push_heap(c.begin(), c.end(), comp);
     }
 
     void pop() {
-        pop_heap(c.begin(), c.end(), comp);
+        ::pop_heap(c.begin(), c.end(), comp);
         c.pop_back();
     }
 };
@@ -96,8 +96,11 @@ struct __slist_iterator : public __slist_iterator_base
     }
 };
 
+/**
+ *  slist 继承自己的节点配置器，从而持有一个 Alloc 对象，复制、移动、交换时按照 __alloc_traits<Alloc> 的规则处理配置器
+*/
 template<class T, class Alloc = __default_alloc_template<0>>
-class slist {
+class slist : protected simple_alloc<__slist_node<T>, Alloc> {
 public:
     typedef  T     value_type;
     typedef  T* pointer;
@@ -105,6 +108,7 @@ public:
     typedef  T&  reference;
     typedef const T&  const_reference;
     typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
 
     typedef __slist_iterator<T, reference, pointer> iterator;
     typedef __slist_iterator<const T, const T&, const T*> const_iterator;
@@ -114,19 +118,91 @@ private:
     typedef __slist_node_base list_node_base;
     typedef __slist_iterator_base iterator_base;
     typedef simple_alloc<list_node, Alloc> list_node_allocator;
+    typedef __alloc_traits<Alloc> alloc_traits;
+    typedef __node_batch<list_node, Alloc> node_batch;
+    typedef __node_release<list_node, Alloc> node_release;
 
-    static list_node* create_node(const value_type& x) {
+    list_node* create_node(const value_type& x) {
         list_node* new_node = list_node_allocator::allocate();
         construct( (&new_node->data), x);
         new_node->next = 0;
         return new_node;
     }
 
-    static void destroy_node(const list_node* node) {
+    // 从 batch 中取出节点并以 x 构造(x 为右值时移动)，用于区间插入
+    template<class V>
+    list_node* create_node(node_batch& batch, V&& x) {
+        list_node* new_node = batch.get();
+        try {
+            construct( (&new_node->data), std::forward<V>(x));
+        } catch(...) {
+            batch.put(new_node);
+            throw;
+        }
+        new_node->next = 0;
+        return new_node;
+    }
+
+    // 将 [first, last) 按原顺序接在 pre 之后，返回最后插入的节点
+    template<class InputIterator>
+    list_node_base* __insert_after_range(list_node_base* pre, InputIterator first, InputIterator last) {
+        node_batch batch(*this, __batch_hint(first, last));
+        for(; first != last; ++first)
+            pre = __slist_node_link(pre, create_node(batch, *first));
+        return pre;
+    }
+
+    // 在 pre 之后插入 n 个 x，返回最后插入的节点
+    list_node_base* __insert_after_fill(list_node_base* pre, size_t n, const value_type& x) {
+        node_batch batch(*this, n);
+        for(; n > 0; --n)
+            pre = __slist_node_link(pre, create_node(batch, x));
+        return pre;
+    }
+
+    // 区间插入，整数类型的"区间"是 n 个 x
+    template<class Integer>
+    void __insert_after_dispatch(list_node_base* pre, Integer n, Integer x, __true_type)
+    { __insert_after_fill(pre, (size_t)n, (value_type)x); }
+    template<class InputIterator>
+    void __insert_after_dispatch(list_node_base* pre, InputIterator first, InputIterator last, __false_type)
+    { __insert_after_range(pre, first, last); }
+
+    void destroy_node(list_node* node) {
         destroy(&(node->data));
         list_node_allocator::deallocate(node);
     }
 
+    // 析构并归还全部节点，不修改 head
+    void release_nodes(__true_type) { }     // 节点空间由配置器整体回收，不需要遍历
+    void release_nodes(__false_type) {
+        node_release released(*this);
+        list_node_base* cur = head.next;
+        while(cur != 0) {
+            list_node* node = (list_node*)cur;
+            cur = cur->next;
+            destroy(&node->data);
+            released.put(node);
+        }
+    }
+
+    // 按原顺序复制 x 的所有元素，*this 必须为空
+    void copy_elements(const slist& x) {
+        node_batch batch(*this, __slist_size(x.head.next));
+        list_node_base* prev = &head;
+        for(list_node_base* cur = x.head.next; cur != 0; cur = cur->next)
+            prev = __slist_node_link(prev, create_node(batch, ((list_node*)cur)->data));
+    }
+
+    // 按原顺序逐个移动 x 的元素，*this 必须为空，x 变为空 slist；配置器不同、不能接管 x 的节点时使用
+    void move_elements(slist& x) {
+        node_batch batch(*this, __slist_size(x.head.next));
+        list_node_base* prev = &head;
+        for(list_node_base* cur = x.head.next; cur != 0; cur = cur->next)
+            prev = __slist_node_link(prev, create_node(batch, std::move(((list_node*)cur)->data)));
+        x.clear();
+    }
+
 private:
     list_node_base head;    // 头部节点，不是指针
     list_node* __inset_after(list_node_base* pre, const value_type& x) {
@@ -135,6 +211,63 @@ private:
 
 public:
     slist() { head.next = 0; }
+    explicit slist(const Alloc& a) : list_node_allocator(a) { head.next = 0; }
+
+    slist(size_t n, const value_type& x, const Alloc& a = Alloc()) : list_node_allocator(a) {
+        head.next = 0;
+        __insert_after_fill(&head, n, x);
+    }
+
+    template<class InputIterator>
+    slist(InputIterator first, InputIterator last, const Alloc& a = Alloc()) : list_node_allocator(a) {
+        head.next = 0;
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        __insert_after_dispatch(&head, first, last, is_integer());
+    }
+
+    slist(const slist& x) : list_node_allocator(alloc_traits::select_on_copy_construction(x.allocator())) {
+        head.next = 0;
+        copy_elements(x);
+    }
+
+    slist(const slist& x, const Alloc& a) : list_node_allocator(a) {
+        head.next = 0;
+        copy_elements(x);
+    }
+
+    // 移动构造，接管 x 的全部节点
+    slist(slist&& x) : list_node_allocator(x.allocator()) {
+        head.next = x.head.next;
+        x.head.next = 0;
+    }
+
+    ~slist() { clear(); }
+
+    slist& operator=(const slist& x) {
+        if(this != &x) {
+            clear();
+            __alloc_copy_assign(this->allocator(), x.allocator());
+            copy_elements(x);
+        }
+        return *this;
+    }
+
+    slist& operator=(slist&& x) noexcept(__alloc_move_noexcept<Alloc>::value) {
+        if(this != &x) {
+            clear();
+            if(__alloc_move_steals(this->allocator(), x.allocator())) {
+                __alloc_move_assign(this->allocator(), x.allocator());
+                head.next = x.head.next;
+                x.head.next = 0;
+            } else {
+                move_elements(x);
+            }
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return this->allocator(); }
+
 public:
     iterator begin() { return iterator((list_node*)head.next); }
     iterator end() { return iterator(0); }   // 空节点
@@ -143,7 +276,18 @@ public:
     iterator insert_after(iterator pos, const value_type& x) {
         return iterator(__inset_after(pos.node, x));
     }
+    // 在 pos 之后插入 n 个 x
+    void insert_after(iterator pos, size_t n, const value_type& x) {
+        __insert_after_fill(pos.node, n, x);
+    }
+    // 将 [first, last) 按原顺序插入 pos 之后，节点成批配置；整数类型的"区间"是 n 个 x
+    template<class InputIterator>
+    void insert_after(iterator pos, InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        __insert_after_dispatch(pos.node, first, last, is_integer());
+    }
     void swap(slist& L) {
+        __alloc_swap(this->allocator(), L.allocator());
         list_node_base* tmp = head.next;
         head.next = L.head.next;
         L.head.next = tmp;
@@ -163,6 +307,12 @@ public:
         head.next = node->next;
         destroy_node((list_node *)node);
     }
+
+    // 移除所有节点
+    void clear() {
+        release_nodes(typename __node_teardown<T, Alloc>::skip());
+        head.next = 0;
+    }
 };
 
 
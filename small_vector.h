@@ -0,0 +1,508 @@
+#ifndef _SMALL_VECTOR_H
+#define _SMALL_VECTOR_H
+
+#include "vector.h"
+
+/**
+ *  small_vector<T, N> 在对象内部保留 N 个元素的空间(内部空间)，元素不超过 N 个时不向配置器申请空间，
+ *  超过 N 个时与 vector 一样向 Alloc 配置空间并按 Growth 增长；之后元素减少也留在配置的空间中，
+ *  直到 shrink_to_fit() 时才搬回内部空间
+ *  接口与 vector 相同，区别在于：
+ *      移动与 swap 时，位于内部空间的元素只能逐个移动，不能直接交换指针；
+ *      因此对位于内部空间的 small_vector 移动或 swap 之后，原先的迭代器全部失效
+*/
+template <class T, size_t N = 8, class Alloc = __default_alloc_template<0>, class Growth = vector_growth_double>
+class small_vector : protected simple_alloc<T, Alloc> {
+    static_assert(N > 0, "small_vector needs at least one inline element");
+
+public:
+    using value_type = T;
+    using iterator   = T*;
+    using const_iterator = const T*;
+    using pointer    = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+
+protected:
+    using data_allocator    =   simple_alloc<T, Alloc>;
+    using alloc_traits      =   __alloc_traits<Alloc>;
+    // 元素能否按位搬移
+    using relocatable       =   typename is_trivially_relocatable<T>::type;
+    iterator start;             // 表示目前使用空间开始地址
+    iterator finish;            // 表示目前使用空间的尾部
+    iterator end_of_storage;    // 表示目前已分配空间的尾部
+    alignas(T) unsigned char storage[N * sizeof(T)];    // 内部空间
+
+    iterator inline_begin() { return reinterpret_cast<iterator>(storage); }
+    bool is_inline() const { return start == reinterpret_cast<const_iterator>(storage); }
+
+    // 回到使用内部空间的空状态，不析构元素也不释放空间
+    void reset_inline() {
+        start = finish = inline_begin();
+        end_of_storage = start + N;
+    }
+
+    // 释放配置的空间，内部空间不需要释放
+    void deallocate() {
+        if(!is_inline())
+            data_allocator::deallocate(start, end_of_storage - start);
+    }
+
+    // 释放全部元素与空间，回到内部空间
+    void release() {
+        destroy(start, finish);
+        deallocate();
+        reset_inline();
+    }
+
+    // 还需要放入 n 个元素时的新容量
+    size_type next_capacity(size_type n) const {
+        return fit_capacity(Growth::grow(size(), n), typename Growth::fit_allocator());
+    }
+    size_type fit_capacity(size_type len, __false_type) const { return len; }
+    size_type fit_capacity(size_type len, __true_type) const { return data_allocator::good_size(len); }
+
+    // 把元素搬到 new_start 开始、容量为 n 的空间(配置的空间或内部空间)，并释放原来配置的空间
+    void relocate(iterator new_start, size_type n, __true_type) {
+        const size_type old_size = size();
+        uninitialized_relocate(start, finish, new_start);
+        deallocate();
+        start = new_start;
+        finish = start + old_size;
+        end_of_storage = start + n;
+    }
+
+    void relocate(iterator new_start, size_type n, __false_type) {
+        const size_type old_size = size();
+        try {
+            uninitialized_move_if_noexcept(start, finish, new_start);
+        } catch(...) {
+            if(new_start != inline_begin())
+                data_allocator::deallocate(new_start, n);
+            throw;
+        }
+        destroy(start, finish);
+        deallocate();
+        start = new_start;
+        finish = start + old_size;
+        end_of_storage = start + n;
+    }
+
+    // 把容量调整为 n (n 大于 N)
+    void grow_to(size_type n, __true_type) {
+        if(is_inline()) {
+            relocate(data_allocator::allocate(n), n, __true_type());
+        } else {
+            // 配置的空间之间按位搬移，交给配置器的 reallocate()
+            const size_type old_size = size();
+            start = data_allocator::reallocate(start, capacity(), n);
+            finish = start + old_size;
+            end_of_storage = start + n;
+        }
+    }
+
+    void grow_to(size_type n, __false_type) { relocate(data_allocator::allocate(n), n, __false_type()); }
+
+    // 在 position 处以 args 构造一个元素
+    template <class... Args>
+    void emplace_aux(iterator position, Args&&... args);
+
+    // 逐个复制 x 的元素，不改变配置器
+    void assign_elements(const small_vector& x);
+
+    // 区间插入与区间赋值，按照迭代器类型分别处理；整数类型的"区间"是 n 个 x
+    template <class Integer>
+    void insert_dispatch(iterator position, Integer n, Integer x, __true_type) { insert(position, (size_type)n, (T)x); }
+    template <class InputIterator>
+    void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+    { range_insert(position, first, last, iterator_category(first)); }
+
+    template <class InputIterator>
+    void range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag);
+    template <class ForwardIterator>
+    void range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
+    template <class Integer>
+    void assign_dispatch(Integer n, Integer x, __true_type) { assign((size_type)n, (T)x); }
+    template <class InputIterator>
+    void assign_dispatch(InputIterator first, InputIterator last, __false_type)
+    { range_assign(first, last, iterator_category(first)); }
+
+    template <class InputIterator>
+    void range_assign(InputIterator first, InputIterator last, input_iterator_tag);
+    template <class ForwardIterator>
+    void range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
+    // 接管 x 的元素：x 使用配置的空间时直接接管指针，否则逐个移动；x 变为空
+    void steal(small_vector& x) {
+        if(x.is_inline()) {
+            finish = uninitialized_move(x.start, x.finish, start);
+            x.clear();
+        } else {
+            start = x.start;
+            finish = x.finish;
+            end_of_storage = x.end_of_storage;
+            x.reset_inline();
+        }
+    }
+
+public:
+    iterator begin() { return start; }
+    iterator end()   { return finish;  }
+    const_iterator begin() const { return start; }
+    const_iterator end() const { return finish; }
+
+    size_type size() const {  return size_type( finish - start ); }
+    size_type capacity()  const   { return size_type(end_of_storage - start ); }
+    bool empty() const { return begin() == end(); }
+
+    reference operator[] (size_type n) { return *( begin() + n ); }
+    const_reference operator[] (size_type n) const { return *(begin() + n); }
+
+    small_vector() { reset_inline(); }
+    explicit small_vector(const Alloc& a) : data_allocator(a) { reset_inline(); }
+    small_vector(size_type n, const T& value, const Alloc& a = Alloc()) : data_allocator(a) { reset_inline(); insert(end(), n, value); }
+    small_vector(int n, const T& value, const Alloc& a = Alloc()) : data_allocator(a) { reset_inline(); insert(end(), n, value); }
+    small_vector(long n, const T& value, const Alloc& a = Alloc()) : data_allocator(a) { reset_inline(); insert(end(), n, value); }
+    explicit small_vector(size_type n, const Alloc& a = Alloc()) : data_allocator(a) { reset_inline(); resize(n); }
+
+    template <class InputIterator>
+    small_vector(InputIterator first, InputIterator last, const Alloc& a = Alloc()) : data_allocator(a) {
+        reset_inline();
+        insert(end(), first, last);
+    }
+
+    small_vector(const small_vector& x) : data_allocator(alloc_traits::select_on_copy_construction(x.allocator())) {
+        reset_inline();
+        assign_elements(x);
+    }
+
+    small_vector(const small_vector& x, const Alloc& a) : data_allocator(a) {
+        reset_inline();
+        assign_elements(x);
+    }
+
+    // 移动构造，配置器随空间一起移动
+    small_vector(small_vector&& x) : data_allocator(x.allocator()) {
+        reset_inline();
+        steal(x);
+    }
+
+    ~small_vector() {
+        destroy(start, finish);
+        deallocate();
+    }
+
+    small_vector& operator=(const small_vector& x) {
+        if(this != &x) {
+            // 配置器将被替换，原空间必须先交还给原来的配置器
+            if(__alloc_copy_changes(this->allocator(), x.allocator()))
+                release();
+            __alloc_copy_assign(this->allocator(), x.allocator());
+            assign_elements(x);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& x) {
+        if(this != &x) {
+            if(__alloc_move_steals(this->allocator(), x.allocator())) {
+                release();
+                __alloc_move_assign(this->allocator(), x.allocator());
+                steal(x);
+            } else {
+                // 配置器不同且不随之移动，x 的空间不能交给 this 释放，逐个移动元素
+                clear();
+                reserve(x.size());
+                finish = uninitialized_move(x.start, x.finish, start);
+                x.clear();
+            }
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return this->allocator(); }
+
+    reference front() { return *begin(); }
+    reference back()  { return *(end() - 1); }
+    const_reference front() const { return *begin(); }
+    const_reference back() const { return *(end() - 1); }
+
+    void push_back(const value_type& x) {
+        if(finish != end_of_storage) {
+            construct(finish, x);
+            ++finish;
+        }
+        else
+            emplace_aux(end(), x);
+    }
+
+    void push_back(value_type&& x) { emplace_back(std::move(x)); }
+
+    template <class... Args>
+    reference emplace_back(Args&&... args) {
+        if(finish != end_of_storage) {
+            construct(finish, std::forward<Args>(args)...);
+            ++finish;
+        }
+        else
+            emplace_aux(end(), std::forward<Args>(args)...);
+        return back();
+    }
+
+    template <class... Args>
+    iterator emplace(const_iterator position, Args&&... args) {
+        const size_type index = position - begin();
+        emplace_aux(start + index, std::forward<Args>(args)...);
+        return start + index;
+    }
+
+    iterator insert(const_iterator position, const T& x) { return emplace(position, x); }
+    iterator insert(const_iterator position, T&& x) { return emplace(position, std::move(x)); }
+    void insert(iterator position, size_type n, const T& x);
+
+    // 插入 [first, last)，前向迭代器只增长一次空间
+    template <class InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        insert_dispatch(position, first, last, is_integer());
+    }
+
+    // 在尾部追加 [first, last) 或者整个区间 r
+    template <class InputIterator>
+    void append_range(InputIterator first, InputIterator last) { insert(end(), first, last); }
+    template <class Range>
+    void append_range(const Range& r) { insert(end(), r.begin(), r.end()); }
+
+    // 以 n 个 x 或者 [first, last) 替换全部内容
+    void assign(size_type n, const T& x);
+    template <class InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        assign_dispatch(first, last, is_integer());
+    }
+
+    void pop_back() {
+        --finish;
+        destroy(finish);
+    }
+
+    iterator erase(iterator position) {
+        if (position + 1 != end())
+            MYSTL::move(position + 1, finish, position);
+        --finish;
+        destroy(finish);
+        return position;
+    }
+
+    iterator erase(iterator first, iterator last) {
+        iterator i = MYSTL::move(last, finish, first);
+        destroy(i, finish);
+        finish = i;
+        return first;
+    }
+
+    void clear() {
+        destroy(start, finish);
+        finish = start;
+    }
+
+    void resize(size_type new_size, const T& x) {
+        if (new_size < size() )
+            erase(begin() + new_size, end());
+        else
+            insert(end(), new_size - size(), x);
+    }
+    void resize(size_type new_size) { resize(new_size, T()); }
+
+    void reserve(size_type n) {
+        if(capacity() < n)
+            grow_to(n, relocatable());
+    }
+
+    // 释放多余的容量：元素不超过 N 个时搬回内部空间，否则容量变为 size()
+    void shrink_to_fit() {
+        if(is_inline() || capacity() == size())
+            return;
+        if(size() <= N)
+            relocate(inline_begin(), N, relocatable());
+        else
+            grow_to(size(), relocatable());
+    }
+
+    void swap(small_vector& x) {
+        if(!is_inline() && !x.is_inline()) {
+            __alloc_swap(this->allocator(), x.allocator());
+            MYSTL::swap(start, x.start);
+            MYSTL::swap(finish, x.finish);
+            MYSTL::swap(end_of_storage, x.end_of_storage);
+        } else {
+            // 至少一边在内部空间，只能逐个移动
+            small_vector tmp(std::move(x));
+            x = std::move(*this);
+            *this = std::move(tmp);
+        }
+    }
+};
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+void small_vector<T, N, Alloc, Growth>::assign_elements(const small_vector& x) {
+    const size_type len = x.size();
+    if(len > capacity()) {
+        // 空间不足，先释放原有元素再配置新空间
+        release();
+        reserve(len);
+        finish = uninitialized_copy(x.begin(), x.end(), start);
+    } else if(size() >= len) {
+        iterator i = MYSTL::copy(x.begin(), x.end(), start);
+        destroy(i, finish);
+        finish = i;
+    } else {
+        MYSTL::copy(x.begin(), x.begin() + size(), start);
+        finish = uninitialized_copy(x.begin() + size(), x.end(), finish);
+    }
+}
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+void small_vector<T, N, Alloc, Growth>::insert(iterator position, size_type n, const T& x) {
+    if(n == 0)
+        return;
+    // x 可能是容器中的元素，先复制一份
+    T x_copy = x;
+    if (size_type(end_of_storage - finish) < n) {
+        const size_type index = position - start;
+        grow_to(next_capacity(n), relocatable());
+        position = start + index;
+    }
+    // 以下计算插入点之后的现有元素个数
+    const size_type elems_after = finish - position;
+    iterator old_finish = finish;
+    if(elems_after > n) {   // 插入点之后元素个数 大于 插入元素个数
+        uninitialized_move(finish - n, finish, finish);
+        finish += n;
+        MYSTL::move_backward(position, old_finish - n, old_finish);
+        MYSTL::fill(position, position + n, x_copy);
+    } else {    // 插入点之后元素个数 少于 插入元素个数
+        uninitialized_fill_n(finish, n - elems_after, x_copy);
+        finish = finish + n - elems_after;
+        uninitialized_move(position, old_finish, finish);
+        finish += elems_after;
+        MYSTL::fill(position, old_finish, x_copy);
+    }
+}
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+template<class... Args>
+void small_vector<T, N, Alloc, Growth>::emplace_aux(iterator position, Args&&... args) {
+    if(finish == end_of_storage) {
+        // args 可能引用容器中的元素，先构造出新元素再增长
+        T x_copy(std::forward<Args>(args)...);
+        const size_type index = position - start;
+        grow_to(next_capacity(1), relocatable());
+        emplace_aux(start + index, std::move(x_copy));
+    } else if(position == finish) {
+        construct(finish, std::forward<Args>(args)...);
+        ++finish;
+    } else {
+        T x_copy(std::forward<Args>(args)...);
+        construct(finish, std::move(*(finish - 1)));
+        ++finish;
+        MYSTL::move_backward(position, finish - 2, finish - 1);
+        *position = std::move(x_copy);
+    }
+}
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+template<class InputIterator>
+void small_vector<T, N, Alloc, Growth>::range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag) {
+    // 输入迭代器不能预先求出长度，只能逐个插入
+    for(; first != last; ++first) {
+        position = insert(position, *first);
+        ++position;
+    }
+}
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+template<class ForwardIterator>
+void small_vector<T, N, Alloc, Growth>::range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+    if(first == last)
+        return;
+    const size_type n = ::distance(first, last);
+    if(size_type(end_of_storage - finish) < n) {
+        // 一次增长足够的空间
+        const size_type index = position - start;
+        grow_to(next_capacity(n), relocatable());
+        position = start + index;
+    }
+    const size_type elems_after = finish - position;
+    iterator old_finish = finish;
+    if(elems_after > n) {
+        uninitialized_move(finish - n, finish, finish);
+        finish += n;
+        MYSTL::move_backward(position, old_finish - n, old_finish);
+        MYSTL::copy(first, last, position);
+    } else {
+        ForwardIterator mid = first;
+        ::advance(mid, elems_after);
+        uninitialized_copy(mid, last, finish);
+        finish += n - elems_after;
+        uninitialized_move(position, old_finish, finish);
+        finish += elems_after;
+        MYSTL::copy(first, mid, position);
+    }
+}
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+void small_vector<T, N, Alloc, Growth>::assign(size_type n, const T& x) {
+    if(n > capacity()) {
+        // 复制一份 x，它可能是容器中的元素
+        T x_copy = x;
+        release();
+        reserve(n);
+        finish = uninitialized_fill_n(start, n, x_copy);
+    } else if(n > size()) {
+        MYSTL::fill(start, finish, x);
+        finish = uninitialized_fill_n(finish, n - size(), x);
+    } else {
+        MYSTL::fill(start, start + n, x);
+        erase(start + n, finish);
+    }
+}
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+template<class InputIterator>
+void small_vector<T, N, Alloc, Growth>::range_assign(InputIterator first, InputIterator last, input_iterator_tag) {
+    iterator cur = start;
+    for(; first != last && cur != finish; ++first, ++cur)
+        *cur = *first;
+    if(first == last)
+        erase(cur, finish);
+    else
+        range_insert(finish, first, last, input_iterator_tag());
+}
+
+template<typename T, size_t N, typename Alloc, typename Growth>
+template<class ForwardIterator>
+void small_vector<T, N, Alloc, Growth>::range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+    const size_type len = ::distance(first, last);
+    if(len > capacity()) {
+        // 空间不足，先释放原有元素再增长空间
+        release();
+        reserve(len);
+        finish = uninitialized_copy(first, last, start);
+    } else if(size() >= len) {
+        erase(MYSTL::copy(first, last, start), finish);
+    } else {
+        ForwardIterator mid = first;
+        ::advance(mid, size());
+        MYSTL::copy(first, mid, start);
+        finish = uninitialized_copy(mid, last, finish);
+    }
+}
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef _SOA_VECTOR_H
+#define _SOA_VECTOR_H
+
+#include <tuple>
+#include "vector.h"
+
+/**
+ *  按列存放的 vector(structure of arrays)
+ *  soa_vector<Fields...> 的每一行由 sizeof...(Fields) 个字段组成，第 I 个字段单独存放在一段连续的列中，
+ *  每一列由 simple_alloc<Field_I, Alloc> 配置，所有列的长度与容量始终相同
+ *  只扫描一两个字段的循环只会读到这些列，每条缓存行都是有用的数据，并且列是普通的数组，编译器可以向量化
+ *  column<I>() 返回第 I 列的 soa_span，get<I>(i) 返回第 i 行的第 I 个字段
+ *  可以按位搬移的列(见 is_trivially_relocatable)增长时通过配置器的 reallocate() 扩展，
+ *  其他列先配置新空间再逐个移动；移动可能抛出异常的列先复制，失败时原来的内容保持不变
+*/
+
+// 第 I 列的元素区间，只是指针与长度，不拥有元素
+template <class T>
+struct soa_span {
+    typedef T           value_type;
+    typedef T*          iterator;
+    typedef T&          reference;
+    typedef size_t      size_type;
+
+    T * ptr;
+    size_t len;
+
+    soa_span(T * p, size_t n) : ptr(p), len(n) { }
+
+    iterator begin() const { return ptr; }
+    iterator end() const { return ptr + len; }
+    T * data() const { return ptr; }
+    size_type size() const { return len; }
+    bool empty() const { return 0 == len; }
+    reference operator[](size_type i) const { return ptr[i]; }
+};
+
+// 用于展开各列的下标序列
+template <size_t... I>
+struct __index_seq { };
+
+template <size_t N, size_t... I>
+struct __make_index_seq : public __make_index_seq<N - 1, N - 1, I...> { };
+
+template <size_t... I>
+struct __make_index_seq<0, I...> {
+    typedef __index_seq<I...> type;
+};
+
+template <class Alloc, class Growth, class... Fields>
+class basic_soa_vector : protected Alloc {
+    static_assert(sizeof...(Fields) > 0, "soa_vector requires at least one field");
+public:
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+    using row_type = std::tuple<Fields...>;
+
+    // 第 I 个字段的类型
+    template <size_t I>
+    using field_type = typename std::tuple_element<I, row_type>::type;
+
+protected:
+    template <size_t I>
+    using column_allocator = simple_alloc<field_type<I>, Alloc>;
+    // 第 I 列能否按位搬移
+    template <size_t I>
+    using relocatable = typename is_trivially_relocatable<field_type<I> >::type;
+    template <size_t I>
+    using column_tag = std::integral_constant<size_t, I>;
+    typedef column_tag<sizeof...(Fields)> end_tag;
+    typedef typename __make_index_seq<sizeof...(Fields)>::type indices;
+    typedef std::tuple<Fields*...> pointers;
+    typedef int __expand[];
+
+    pointers columns;       // 各列的起始地址
+    size_type count;        // 行数
+    size_type cap;          // 各列的容量
+
+    Alloc& allocator() { return *this; }
+    const Alloc& allocator() const { return *this; }
+
+    template <size_t I>
+    field_type<I> * col() const { return std::get<I>(columns); }
+
+    // 还需要放入 n 行时的新容量
+    size_type next_capacity(size_type n) const { return Growth::grow(count, n); }
+
+    void reserve_more(size_type n) {
+        if(cap - count < n)
+            reallocate_storage(next_capacity(n));
+    }
+
+    /**
+     *  将容量调整为 n：
+     *      1. 为不能按位搬移的列配置新空间
+     *      2. 移动可能抛出异常的列复制到新空间，失败时释放新空间，原来的列保持不变
+     *      3. 其余不能按位搬移的列移动到新空间，可以按位搬移的列交给 reallocate()，这一步不会抛出异常
+    */
+    void reallocate_storage(size_type n) {
+        pointers to;
+        allocate_columns(to, n, indices());
+        try {
+            copy_columns(to, column_tag<0>());
+        } catch(...) {
+            deallocate_new_columns(to, n, indices());
+            throw;
+        }
+        move_columns(to, n, indices());
+        cap = n;
+    }
+
+    template <size_t... I>
+    void allocate_columns(pointers& to, size_type n, __index_seq<I...>) {
+        (void)__expand{ 0, (std::get<I>(to) = allocate_column<I>(n, relocatable<I>()), 0)... };
+    }
+    template <size_t I>
+    field_type<I> * allocate_column(size_type, __true_type) { return nullptr; }
+    template <size_t I>
+    field_type<I> * allocate_column(size_type n, __false_type) { return column_allocator<I>(allocator()).allocate(n); }
+
+    template <size_t... I>
+    void deallocate_new_columns(pointers& to, size_type n, __index_seq<I...>) {
+        (void)__expand{ 0, (deallocate_new_column<I>(to, n, relocatable<I>()), 0)... };
+    }
+    template <size_t I>
+    void deallocate_new_column(pointers&, size_type, __true_type) { }
+    template <size_t I>
+    void deallocate_new_column(pointers& to, size_type n, __false_type) { column_allocator<I>(allocator()).deallocate(std::get<I>(to), n); }
+
+    // 第二步，依次处理第 I 列及之后的列，后面的列失败时销毁已经复制好的列
+    void copy_columns(pointers&, end_tag) { }
+    template <size_t I>
+    void copy_columns(pointers& to, column_tag<I>) {
+        typedef field_type<I> F;
+        const bool copies = !std::is_same<relocatable<I>, __true_type>::value && !std::is_nothrow_move_constructible<F>::value;
+        if(copies)
+            uninitialized_move_if_noexcept(col<I>(), col<I>() + count, std::get<I>(to));
+        try {
+            copy_columns(to, column_tag<I + 1>());
+        } catch(...) {
+            if(copies)
+                destroy(std::get<I>(to), std::get<I>(to) + count);
+            throw;
+        }
+    }
+
+    // 第三步
+    template <size_t... I>
+    void move_columns(pointers& to, size_type n, __index_seq<I...>) {
+        (void)__expand{ 0, (move_column<I>(to, n, relocatable<I>()), 0)... };
+        columns = to;
+    }
+    template <size_t I>
+    void move_column(pointers& to, size_type n, __true_type) {
+        std::get<I>(to) = column_allocator<I>(allocator()).reallocate(col<I>(), cap, n);
+    }
+    template <size_t I>
+    void move_column(pointers& to, size_type, __false_type) {
+        if(std::is_nothrow_move_constructible<field_type<I> >::value)
+            uninitialized_move(col<I>(), col<I>() + count, std::get<I>(to));
+        destroy(col<I>(), col<I>() + count);
+        column_allocator<I>(allocator()).deallocate(col<I>(), cap);
+    }
+
+    // 在第 i 行以 t 中的各个参数构造各列，后面的列失败时销毁前面已经构造的字段
+    template <class Tuple>
+    void construct_row(size_type, Tuple&, end_tag) { }
+    template <class Tuple, size_t I>
+    void construct_row(size_type i, Tuple& t, column_tag<I>) {
+        typedef typename std::tuple_element<I, Tuple>::type Arg;
+        construct(col<I>() + i, std::forward<Arg>(std::get<I>(t)));
+        try {
+            construct_row(i, t, column_tag<I + 1>());
+        } catch(...) {
+            destroy(col<I>() + i);
+            throw;
+        }
+    }
+
+    // 把 x 的各列复制到容量刚好为 x.size() 的新空间，失败时释放全部空间
+    void copy_from(const basic_soa_vector& x) {
+        count = 0;
+        cap = x.count;
+        init_columns(cap, indices());
+        try {
+            copy_column_from(x, column_tag<0>());
+        } catch(...) {
+            free_columns(indices());
+            throw;
+        }
+        count = x.count;
+    }
+
+    template <size_t... I>
+    void init_columns(size_type n, __index_seq<I...>) {
+        (void)__expand{ 0, (std::get<I>(columns) = column_allocator<I>(allocator()).allocate(n), 0)... };
+    }
+
+    void copy_column_from(const basic_soa_vector&, end_tag) { }
+    template <size_t I>
+    void copy_column_from(const basic_soa_vector& x, column_tag<I>) {
+        uninitialized_copy(x.col<I>(), x.col<I>() + x.count, col<I>());
+        try {
+            copy_column_from(x, column_tag<I + 1>());
+        } catch(...) {
+            destroy(col<I>(), col<I>() + x.count);
+            throw;
+        }
+    }
+
+    // 销毁 [first, last) 行
+    template <size_t... I>
+    void destroy_rows(size_type first, size_type last, __index_seq<I...>) {
+        (void)__expand{ 0, (destroy(col<I>() + first, col<I>() + last), 0)... };
+    }
+
+    // 释放各列的空间，元素必须已经销毁
+    template <size_t... I>
+    void free_columns(__index_seq<I...>) {
+        (void)__expand{ 0, (column_allocator<I>(allocator()).deallocate(col<I>(), cap), 0)... };
+    }
+
+    void release() {
+        destroy_rows(0, count, indices());
+        free_columns(indices());
+        columns = pointers();
+        count = cap = 0;
+    }
+
+    void steal(basic_soa_vector& x) {
+        columns = x.columns;
+        count = x.count;
+        cap = x.cap;
+        x.columns = pointers();
+        x.count = x.cap = 0;
+    }
+
+    // 交换各列的空间，不交换配置器
+    void swap_storage(basic_soa_vector& x) {
+        MYSTL::swap(columns, x.columns);
+        MYSTL::swap(count, x.count);
+        MYSTL::swap(cap, x.cap);
+    }
+
+    // 第 pos 行之后的各行后移一行，并以 t 中的字段赋值第 pos 行
+    template <size_t... I>
+    void shift_in(size_type pos, row_type& t, __index_seq<I...>) {
+        (void)__expand{ 0, (shift_column_in<I>(pos, std::get<I>(t)), 0)... };
+    }
+    template <size_t I>
+    void shift_column_in(size_type pos, field_type<I>& x) {
+        field_type<I> * c = col<I>();
+        construct(c + count, std::move(c[count - 1]));
+        MYSTL::move_backward(c + pos, c + count - 1, c + count);
+        c[pos] = std::move(x);
+    }
+
+    template <size_t... I>
+    void erase_rows(size_type first, size_type last, __index_seq<I...>) {
+        (void)__expand{ 0, (MYSTL::move(col<I>() + last, col<I>() + count, col<I>() + first), 0)... };
+    }
+
+    template <size_t... I>
+    void default_construct_rows(size_type first, size_type last, __index_seq<I...>) {
+        (void)__expand{ 0, (uninitialized_default_construct(col<I>() + first, col<I>() + last), 0)... };
+    }
+
+public:
+    basic_soa_vector() : count(0), cap(0) { }
+    explicit basic_soa_vector(const Alloc& a) : Alloc(a), count(0), cap(0) { }
+
+    basic_soa_vector(const basic_soa_vector& x) : Alloc(__alloc_traits<Alloc>::select_on_copy_construction(x.allocator())) { copy_from(x); }
+    basic_soa_vector(const basic_soa_vector& x, const Alloc& a) : Alloc(a) { copy_from(x); }
+    basic_soa_vector(basic_soa_vector&& x) : Alloc(x.allocator()) { steal(x); }
+
+    ~basic_soa_vector() {
+        destroy_rows(0, count, indices());
+        free_columns(indices());
+    }
+
+    basic_soa_vector& operator=(const basic_soa_vector& x) {
+        if(this != &x) {
+            if(__alloc_copy_changes(allocator(), x.allocator()))
+                release();
+            __alloc_copy_assign(allocator(), x.allocator());
+            basic_soa_vector tmp(x, allocator());
+            swap_storage(tmp);
+        }
+        return *this;
+    }
+
+    basic_soa_vector& operator=(basic_soa_vector&& x) {
+        if(this != &x) {
+            if(__alloc_move_steals(allocator(), x.allocator())) {
+                release();
+                __alloc_move_assign(allocator(), x.allocator());
+                steal(x);
+            } else {
+                basic_soa_vector tmp(x, allocator());
+                swap_storage(tmp);
+            }
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return allocator(); }
+
+    size_type size() const { return count; }
+    size_type capacity() const { return cap; }
+    bool empty() const { return 0 == count; }
+
+    // 第 I 列
+    template <size_t I>
+    soa_span<field_type<I> > column() { return soa_span<field_type<I> >(col<I>(), count); }
+    template <size_t I>
+    soa_span<const field_type<I> > column() const { return soa_span<const field_type<I> >(col<I>(), count); }
+
+    template <size_t I>
+    field_type<I> * data() { return col<I>(); }
+    template <size_t I>
+    const field_type<I> * data() const { return col<I>(); }
+
+    // 第 i 行的第 I 个字段
+    template <size_t I>
+    field_type<I>& get(size_type i) { return col<I>()[i]; }
+    template <size_t I>
+    const field_type<I>& get(size_type i) const { return col<I>()[i]; }
+
+    void push_back(const Fields&... xs) { emplace_back(xs...); }
+    void push_back(Fields&&... xs) { emplace_back(std::move(xs)...); }
+
+    // 在尾部追加一行，第 I 个参数构造第 I 个字段
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "emplace_back takes one argument per field");
+        if(count == cap) {
+            // 参数可能引用本容器中的字段，先构造出一行再扩充容量
+            row_type tmp(std::forward<Args>(args)...);
+            reserve_more(1);
+            construct_row(count, tmp, column_tag<0>());
+        } else {
+            std::tuple<Args&&...> t(std::forward<Args>(args)...);
+            construct_row(count, t, column_tag<0>());
+        }
+        ++count;
+    }
+
+    // 在第 pos 行之前插入一行
+    template <class... Args>
+    void emplace(size_type pos, Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "emplace takes one argument per field");
+        if(pos == count) {
+            emplace_back(std::forward<Args>(args)...);
+            return;
+        }
+        row_type tmp(std::forward<Args>(args)...);
+        reserve_more(1);
+        shift_in(pos, tmp, indices());
+        ++count;
+    }
+
+    void insert(size_type pos, const Fields&... xs) { emplace(pos, xs...); }
+
+    void pop_back() {
+        --count;
+        destroy_rows(count, count + 1, indices());
+    }
+
+    // 删除 [first, last) 行，各列同时前移，返回 first
+    size_type erase(size_type first, size_type last) {
+        erase_rows(first, last, indices());
+        destroy_rows(count - (last - first), count, indices());
+        count -= last - first;
+        return first;
+    }
+
+    size_type erase(size_type pos) { return erase(pos, pos + 1); }
+
+    void clear() {
+        destroy_rows(0, count, indices());
+        count = 0;
+    }
+
+    // 新增的行默认初始化，对 POD 字段相当于不初始化
+    void resize(size_type n) {
+        if(n < count) {
+            erase(n, count);
+        } else {
+            reserve_more(n - count);
+            default_construct_rows(count, n, indices());
+            count = n;
+        }
+    }
+
+    void reserve(size_type n) {
+        if(cap < n)
+            reallocate_storage(n);
+    }
+
+    void shrink_to_fit() {
+        if(cap != count)
+            reallocate_storage(count);
+    }
+
+    void swap(basic_soa_vector& x) {
+        __alloc_swap(allocator(), x.allocator());
+        swap_storage(x);
+    }
+};
+
+// 使用默认配置器与两倍增长的 soa_vector
+template <class... Fields>
+using soa_vector = basic_soa_vector<__default_alloc_template<0>, vector_growth_double, Fields...>;
+
+#endif
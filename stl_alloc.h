@@ -2,75 +2,537 @@
 #define _STL_ALLOC_H
 
 #include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 #include <iostream>
+#include "type_traits.h"
+#include "stl_iterator.h"
+#ifdef __STL_THREADS
+#include <mutex>
+#endif
+
+// 定义 __STL_ALLOC_PROFILE 后 simple_alloc 的配置与释放交给抽样堆分析器统计
+#ifdef __STL_ALLOC_PROFILE
+#include "stl_alloc_profile.h"
+#define __STL_PROFILE_ALLOC(p, bytes)   alloc_profiler::on_allocate(p, bytes)
+#define __STL_PROFILE_FREE(p, bytes)    alloc_profiler::on_deallocate(p, bytes)
+#else
+#define __STL_PROFILE_ALLOC(p, bytes)
+#define __STL_PROFILE_FREE(p, bytes)
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define __STL_HAS_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 
 // 构造器前置声明
 template<int inst> class __malloc_alloc_template;
 template<int inst> class __default_alloc_template;
 
+/**
+ *  成批配置与释放
+ *  配置器可以提供以下成员，一次配置或释放 count 个大小为 n 的区块：
+ *      allocate_batch(size_t n, size_t count, void ** out);
+ *      deallocate_batch(size_t n, size_t count, void ** p);
+ *  没有提供时退化为逐个调用 allocate/deallocate
+*/
+template<class Alloc>
+inline auto __alloc_allocate_batch(Alloc& a, size_t n, size_t count, void ** out, int)
+    -> decltype(a.allocate_batch(n, count, out))
+{ return a.allocate_batch(n, count, out); }
+
+template<class Alloc>
+inline void __alloc_allocate_batch(Alloc& a, size_t n, size_t count, void ** out, long) {
+    for(size_t i = 0; i < count; ++i)
+        out[i] = a.allocate(n);
+}
+
+/**
+ *  重新配置
+ *  配置器提供 reallocate(void * p, size_t old_size, size_t new_size) 时使用它，
+ *  否则配置新空间、按位复制旧内容并释放旧空间；只能用于可以按位搬移的内容
+*/
+template<class Alloc>
+inline auto __alloc_reallocate(Alloc& a, void * p, size_t old_size, size_t new_size, int)
+    -> decltype(a.reallocate(p, old_size, new_size))
+{ return a.reallocate(p, old_size, new_size); }
+
+template<class Alloc>
+inline void * __alloc_reallocate(Alloc& a, void * p, size_t old_size, size_t new_size, long) {
+    void * result = a.allocate(new_size);
+    memcpy(result, p, old_size < new_size ? old_size : new_size);
+    a.deallocate(p, old_size);
+    return result;
+}
+
+/**
+ *  配置器对 n 个字节的请求实际给出的字节数
+ *  配置器提供 good_size(size_t n) 时使用它，否则就是 n；容器可以据此把容量上调到不浪费的大小
+*/
+template<class Alloc>
+inline auto __alloc_good_size(const Alloc& a, size_t n, int)
+    -> decltype(a.good_size(n))
+{ return a.good_size(n); }
+
+template<class Alloc>
+inline size_t __alloc_good_size(const Alloc&, size_t n, long) { return n; }
+
+template<class Alloc>
+inline auto __alloc_deallocate_batch(Alloc& a, size_t n, size_t count, void ** p, int)
+    -> decltype(a.deallocate_batch(n, count, p))
+{ return a.deallocate_batch(n, count, p); }
+
+template<class Alloc>
+inline void __alloc_deallocate_batch(Alloc& a, size_t n, size_t count, void ** p, long) {
+    for(size_t i = 0; i < count; ++i)
+        a.deallocate(p[i], n);
+}
+
 /**
  *  SGI采用二级配置器对内存分配进行管理，为了适配STL的内存分配接口，使用simple_alloc进行一层接口包装
  *  simple_alloc调用底层 Alloc 进行内存配置。
+ *  容器继承 simple_alloc，从而持有一个 Alloc 对象：
+ *      malloc_alloc / __default_alloc_template 这类只有静态接口的配置器是空类，借助空基类优化不占空间；
+ *      有状态的配置器(例如绑定某个 arena 或 pool 的句柄)则随容器保存，每个容器可以使用不同的内存来源。
+ *  Alloc 的 allocate/deallocate 既可以是静态函数，也可以是成员函数。
 */
 template<class T, class Alloc>
-class simple_alloc
+class simple_alloc : public Alloc
 {
 public:
-    static T* allocate(size_t n)
-    {   return 0 == n ? 0 : (T*) Alloc::allocate(n * sizeof(T));  }
+    simple_alloc() { }
+    simple_alloc(const Alloc& a) : Alloc(a) { }
+
+    T* allocate(size_t n)
+    {
+        if(0 == n) return 0;
+        T* p = (T*) Alloc::allocate(n * sizeof(T));
+        __STL_PROFILE_ALLOC(p, n * sizeof(T));
+        return p;
+    }
+
+    T* allocate(void)
+    {
+        T* p = (T*) Alloc::allocate(sizeof(T));
+        __STL_PROFILE_ALLOC(p, sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if(0 == n) return;
+        __STL_PROFILE_FREE(p, n * sizeof(T));
+        Alloc::deallocate(p, n * sizeof(T));
+    }
+
+    void deallocate(T* p)
+    {
+        __STL_PROFILE_FREE(p, sizeof(T));
+        Alloc::deallocate(p, sizeof(T));
+    }
 
-    static T* allocate(void)
-    { return (T*) Alloc::allocate(sizeof(T)); }
+    // 将 p 处 old_n 个 T 的空间调整为 new_n 个，内容按位搬移，T 必须可以按位搬移
+    T* reallocate(T* p, size_t old_n, size_t new_n)
+    {
+        if(0 == old_n) { deallocate(p, old_n); return allocate(new_n); }
+        if(0 == new_n) { deallocate(p, old_n); return 0; }
+        __STL_PROFILE_FREE(p, old_n * sizeof(T));
+        T* result = (T*) __alloc_reallocate(allocator(), p, old_n * sizeof(T), new_n * sizeof(T), 0);
+        __STL_PROFILE_ALLOC(result, new_n * sizeof(T));
+        return result;
+    }
 
-    static void deallocate(T* p, size_t n)
-    { if(0 != n) Alloc::deallocate(p, n * sizeof(T)); }
+    // 配置 n 个 T 时实际得到的空间可以容纳的 T 的个数，不小于 n
+    size_t good_size(size_t n) const
+    { return 0 == n ? 0 : __alloc_good_size(allocator(), n * sizeof(T), 0) / sizeof(T); }
 
-    static void deallocate(T* p)
-    { Alloc::deallocate(p, sizeof(T)); }
+    // 一次配置 / 释放 count 个 T 大小的区块，用于节点容器的区间操作
+    void allocate_batch(void ** out, size_t count)
+    {
+        if(0 == count) return;
+        __alloc_allocate_batch(allocator(), sizeof(T), count, out, 0);
+#ifdef __STL_ALLOC_PROFILE
+        for(size_t i = 0; i < count; ++i)
+            __STL_PROFILE_ALLOC(out[i], sizeof(T));
+#endif
+    }
+
+    void deallocate_batch(void ** p, size_t count)
+    {
+        if(0 == count) return;
+#ifdef __STL_ALLOC_PROFILE
+        for(size_t i = 0; i < count; ++i)
+            __STL_PROFILE_FREE(p[i], sizeof(T));
+#endif
+        __alloc_deallocate_batch(allocator(), sizeof(T), count, p, 0);
+    }
+
+    // 容器持有的配置器对象
+    Alloc& allocator() { return *this; }
+    const Alloc& allocator() const { return *this; }
+};
+
+enum { __NODE_BATCH = 64 };     // 节点容器一批配置的节点数量
+
+/**
+ *  __node_batch 为节点容器的区间构造、区间插入成批配置节点
+ *  get() 取出一个未构造的节点，取完时通过 allocate_batch() 再配置一批；
+ *  析构时把没有用到的节点通过 deallocate_batch() 一次归还
+ *  expected 为预计需要的节点数量，0 表示未知，此时每批配置 __NODE_BATCH 个
+*/
+template<class Node, class Alloc>
+class __node_batch {
+private:
+    simple_alloc<Node, Alloc>& alloc;
+    void * nodes[__NODE_BATCH];
+    size_t next;        // 下一个可用节点
+    size_t count;       // 本批配置的节点数量
+    size_t expected;    // 预计还需要的节点数量
+
+    __node_batch(const __node_batch&);
+    __node_batch& operator=(const __node_batch&);
+
+public:
+    explicit __node_batch(simple_alloc<Node, Alloc>& a, size_t n = 0) : alloc(a), next(0), count(0), expected(n) { }
+
+    ~__node_batch() { alloc.deallocate_batch(nodes + next, count - next); }
+
+    Node* get() {
+        if(next == count) {
+            count = (0 == expected || expected > (size_t)__NODE_BATCH) ? (size_t)__NODE_BATCH : expected;
+            expected = expected > count ? expected - count : 0;
+            alloc.allocate_batch(nodes, count);
+            next = 0;
+        }
+        return (Node*)nodes[next++];
+    }
+
+    // 退回最近一次 get() 取出但没有使用的节点(例如构造元素时抛出异常)
+    void put(Node* p) { nodes[--next] = p; }
+};
+
+/**
+ *  __node_release 为节点容器的 clear() 与析构成批归还节点
+ *  put() 收集析构过的节点，攒够 __NODE_BATCH 个时通过 deallocate_batch() 一次归还，析构时归还剩下的
+ *  成批归还省下的是每个节点一次加锁，没有定义 __STL_THREADS 时直接逐个归还，不再额外缓存
+*/
+template<class Node, class Alloc>
+class __node_release {
+private:
+    simple_alloc<Node, Alloc>& alloc;
+    void * nodes[__NODE_BATCH];
+    size_t count;
+
+    __node_release(const __node_release&);
+    __node_release& operator=(const __node_release&);
+
+public:
+    explicit __node_release(simple_alloc<Node, Alloc>& a) : alloc(a), count(0) { }
+
+    ~__node_release() { alloc.deallocate_batch(nodes, count); }
+
+    void put(Node* p) {
+#ifdef __STL_THREADS
+        nodes[count++] = p;
+        if(count == (size_t)__NODE_BATCH) {
+            alloc.deallocate_batch(nodes, count);
+            count = 0;
+        }
+#else
+        alloc.deallocate(p);
+#endif
+    }
+};
+
+// 区间需要的节点数量，只有随机访问迭代器能直接求出，其他情况返回 0 表示未知
+template<class InputIterator>
+inline size_t __batch_hint(InputIterator, InputIterator, input_iterator_tag) { return 0; }
+
+template<class RandomAccessIterator>
+inline size_t __batch_hint(RandomAccessIterator first, RandomAccessIterator last, random_iterator_tag)
+{ return last - first; }
+
+template<class InputIterator>
+inline size_t __batch_hint(InputIterator first, InputIterator last)
+{ return __batch_hint(first, last, iterator_category(first)); }
+
+/**
+ *  __alloc_traits 描述容器在复制、移动、交换时如何对待自己持有的配置器对象：
+ *      复制构造时使用 select_on_copy_construction() 的结果；
+ *      propagate_on_copy_assignment 为 __true_type 时，复制赋值把对方的配置器一起复制过来；
+ *      propagate_on_move_assignment 为 __true_type 时，移动赋值把对方的配置器一起移动过来；
+ *      propagate_on_swap 为 __true_type 时，swap 同时交换两边的配置器。
+ *  不传递配置器时，只有两边的配置器相等(equal() 为 true)才能直接接管对方的空间，否则逐个复制元素。
+ *  is_always_equal 为 __true_type 表示同类型的配置器对象总是相等，移动赋值一定能直接接管对方的空间。
+ *  noop_deallocate 为 __true_type 表示 deallocate() 什么都不做，空间由配置器整体回收(例如 arena)，
+ *  此时元素可以平凡析构的节点容器在 clear() 与析构时不需要遍历节点。
+ *  默认版本针对只有静态接口的配置器，所有对象都相等；
+ *  有状态的配置器应当特化 __alloc_traits，一般直接继承 __stateful_alloc_traits 即可。
+*/
+template<class Alloc>
+struct __alloc_traits {
+    typedef __false_type    propagate_on_copy_assignment;
+    typedef __true_type     propagate_on_move_assignment;
+    typedef __true_type     propagate_on_swap;
+    typedef __true_type     is_always_equal;
+    typedef __false_type    noop_deallocate;
+
+    static Alloc select_on_copy_construction(const Alloc& a) { return a; }
+    static bool equal(const Alloc&, const Alloc&) { return true; }
+};
+
+// 有状态配置器的默认规则：复制赋值时保留自己的配置器，移动赋值与 swap 时随内容转移，用 operator== 判断相等
+template<class Alloc>
+struct __stateful_alloc_traits {
+    typedef __false_type    propagate_on_copy_assignment;
+    typedef __true_type     propagate_on_move_assignment;
+    typedef __true_type     propagate_on_swap;
+    typedef __false_type    is_always_equal;
+    typedef __false_type    noop_deallocate;
+
+    static Alloc select_on_copy_construction(const Alloc& a) { return a; }
+    static bool equal(const Alloc& a, const Alloc& b) { return a == b; }
+};
+
+// 以下全局函数供容器在赋值与交换时按照 __alloc_traits 的规则处理配置器
+inline bool __alloc_propagates(__true_type) { return true; }
+inline bool __alloc_propagates(__false_type) { return false; }
+
+template<class Alloc>
+inline void __alloc_assign(Alloc& to, const Alloc& from, __true_type) { to = from; }
+
+template<class Alloc>
+inline void __alloc_assign(Alloc&, const Alloc&, __false_type) { }
+
+// 复制赋值之后 to 是否会换成另一个配置器，是则容器需要先用原来的配置器释放全部空间
+template<class Alloc>
+inline bool __alloc_copy_changes(const Alloc& to, const Alloc& from) {
+    return __alloc_propagates(typename __alloc_traits<Alloc>::propagate_on_copy_assignment())
+           && !__alloc_traits<Alloc>::equal(to, from);
+}
+
+template<class Alloc>
+inline void __alloc_copy_assign(Alloc& to, const Alloc& from) {
+    __alloc_assign(to, from, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+}
+
+// 移动赋值时能否直接接管 from 的空间：配置器随之移动，或两边的配置器相等
+template<class Alloc>
+inline bool __alloc_move_steals(const Alloc& to, const Alloc& from) {
+    return __alloc_propagates(typename __alloc_traits<Alloc>::propagate_on_move_assignment())
+           || __alloc_traits<Alloc>::equal(to, from);
+}
+
+// 移动赋值是否一定只接管空间、不会抛出异常：配置器随之移动，或者配置器总是相等
+template<class Alloc>
+struct __alloc_move_noexcept : public std::integral_constant<bool,
+    std::is_same<typename __alloc_traits<Alloc>::propagate_on_move_assignment, __true_type>::value ||
+    std::is_same<typename __alloc_traits<Alloc>::is_always_equal, __true_type>::value> { };
+
+template<class Alloc>
+inline void __alloc_move_assign(Alloc& to, const Alloc& from) {
+    __alloc_assign(to, from, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+}
+
+template<class Alloc>
+inline void __alloc_swap(Alloc& a, Alloc& b, __true_type) {
+    Alloc tmp = a;
+    a = b;
+    b = tmp;
+}
+
+template<class Alloc>
+inline void __alloc_swap(Alloc& a, Alloc& b, __false_type) {
+    // 不交换配置器时，两个容器的配置器必须相等
+    assert(__alloc_traits<Alloc>::equal(a, b));
+}
+
+template<class Alloc>
+inline void __alloc_swap(Alloc& a, Alloc& b) {
+    __alloc_swap(a, b, typename __alloc_traits<Alloc>::propagate_on_swap());
+}
+
+/**
+ *  节点容器整体销毁全部节点时能否跳过遍历：元素可以平凡析构，并且配置器的 deallocate() 什么都不做
+ *  type 为 __false_type 时逐个析构元素，并通过 __node_release 成批归还节点
+*/
+template<class T, class Alloc>
+struct __node_teardown {
+    typedef typename __bool_type<std::is_same<typename __type_traits<T>::has_trivial_destructor, __true_type>::value
+                                 && std::is_same<typename __alloc_traits<Alloc>::noop_deallocate, __true_type>::value>::type skip;
 };
 
 
 /**
  *  第一级内存管理器
- *  对于超过128bytes分配请求都算做大内存
- *  直接调用placement new 分配大内存
+ *  对于超过 __MAX_BYTES 的分配请求都算做大内存
+ *  大内存分为三层：
+ *      不超过 __STL_LARGE_CACHE_MIN 的空间直接调用 malloc/free；
+ *      (__STL_LARGE_CACHE_MIN, __STL_MMAP_THRESHOLD) 之间的空间按大小类别上调后 malloc，
+ *      释放时先放入对应类别的缓存链表，下次同类别的请求直接取出；
+ *      不小于 __STL_MMAP_THRESHOLD 的空间直接 mmap，头部记录映射的长度，释放时同样先缓存，
+ *      reallocate() 时映射够用则原地返回，不够时通过 mremap 增长，不需要复制内容
+ *  两层缓存的总量不超过 __STL_LARGE_CACHE_BYTES，超出时直接归还系统
+ *  deallocate / reallocate 依靠调用者传入的大小找到区块所在的层，传入的大小必须与配置时相同
+ *  内存不足时先归还缓存，再调用 oom_handler
  *  一般而言不需要模板参数，inst没有派上用场
 */
+#ifndef __STL_LARGE_CACHE_MIN
+#define __STL_LARGE_CACHE_MIN 4096
+#endif
+
+#ifndef __STL_MMAP_THRESHOLD
+#define __STL_MMAP_THRESHOLD (1024 * 1024)
+#endif
+
+#ifndef __STL_LARGE_CACHE_BYTES
+#define __STL_LARGE_CACHE_BYTES (32 * 1024 * 1024)
+#endif
+
+static_assert((__STL_LARGE_CACHE_MIN & (__STL_LARGE_CACHE_MIN - 1)) == 0
+              && (__STL_MMAP_THRESHOLD & (__STL_MMAP_THRESHOLD - 1)) == 0
+              && __STL_LARGE_CACHE_MIN < __STL_MMAP_THRESHOLD,
+              "__STL_LARGE_CACHE_MIN and __STL_MMAP_THRESHOLD must be increasing powers of two");
+
+// 编译期求 2 的幂的指数
+constexpr int __log2_pow2(size_t x) { return x <= 1 ? 0 : 1 + __log2_pow2(x >> 1); }
 
 #define __THROW_BAD_ALLOC   std::cerr << "out of memory" << std::endl; exit(1)
 template <int inst>
 class __malloc_alloc_template
 {
 private:
+    // 缓存层每个区间 (2^k, 2^(k+1)] 等分为 __LARGE_STEPS 个类别
+    enum { __LARGE_STEPS = 4 };
+    enum { __LARGE_MIN_SHIFT = __log2_pow2(__STL_LARGE_CACHE_MIN) };
+    enum { __NLARGELISTS = (__log2_pow2(__STL_MMAP_THRESHOLD) - __LARGE_MIN_SHIFT) * __LARGE_STEPS };
+
+    // 缓存的空闲区块用第一个字保存下一个区块
+    static void * large_free[__NLARGELISTS];
+    static size_t cached_bytes;     // 两层缓存中的字节数
+#ifdef __STL_THREADS
+    static std::mutex large_lock;
+#endif
+
+    static bool is_cached(size_t n) {
+        return n > (size_t)__STL_LARGE_CACHE_MIN && n < (size_t)__STL_MMAP_THRESHOLD;
+    }
+
+    static bool is_mapped(size_t n) {
+#ifdef __STL_HAS_MMAP
+        return n >= (size_t)__STL_MMAP_THRESHOLD;
+#else
+        return false;
+#endif
+    }
+
+    // 缓存层的类别编号，n 必须满足 is_cached(n)
+    static size_t large_index(size_t n) {
+        size_t k = __LARGE_MIN_SHIFT;
+        while(((size_t)1 << (k + 1)) < n) ++k;     // 2^k < n <= 2^(k+1)
+        size_t step = ((size_t)1 << k) / __LARGE_STEPS;
+        return (k - __LARGE_MIN_SHIFT) * __LARGE_STEPS + (n - ((size_t)1 << k) + step - 1) / step - 1;
+    }
+
+    static size_t large_size(size_t i) {
+        size_t base = (size_t)__STL_LARGE_CACHE_MIN << (i / __LARGE_STEPS);
+        return base + (i % __LARGE_STEPS + 1) * (base / __LARGE_STEPS);
+    }
+
+    // 实际 malloc 的大小
+    static size_t block_size(size_t n) {
+        return is_cached(n) ? large_size(large_index(n)) : n;
+    }
+
+    // 从缓存中取出一个 n 所在类别的区块，没有时返回 0
+    static void * cache_fetch(size_t n);
+    // 将区块放入缓存，缓存已满时返回 false
+    static bool cache_put(void * p, size_t n);
+
+#ifdef __STL_HAS_MMAP
+    // mmap 层区块的头部，大小为 __MAP_HEADER，返回给调用者的地址仍按缓存行对齐
+    struct map_header {
+        size_t length;          // 包括头部在内映射的字节数
+        map_header * next;      // 缓存链表
+    };
+    enum { __MAP_HEADER = 64 };
+
+    static map_header * map_cache;
+
+    static size_t map_length(size_t n) {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        return (n + __MAP_HEADER + page - 1) & ~(page - 1);
+    }
+
+    static map_header * header(void * p) { return (map_header *)((char *)p - __MAP_HEADER); }
+
+    // 优先使用缓存中长度足够且不超过两倍的映射，失败时返回 0
+    static void * map_alloc(size_t n);
+    static void map_free(void * p);
+    // 调整映射的大小，失败时返回 0，原映射仍然有效
+    static void * map_resize(void * p, size_t new_size);
+#endif
+
+    // 向系统申请 / 归还空间，失败时返回 0
+    static void * system_alloc(size_t n);
+    static void system_free(void * p, size_t n);
+
     // oom : out of memory
     // 在内存不足时调用
     static void * oom_malloc(size_t);
     static void * oom_realloc(void *, size_t);
+    static void * oom_malloc_aligned(size_t, size_t);
     // 内存分配失败时处理函数指针，指向执行的处理函数
     static void (* __malloc_alloc_oom_handler) ();
 
 public:
-    // 第一级配置器直接调用malloc()申请内存
     static void * allocate(size_t n)
     {
-        void * result = malloc(n);
+        void * result = is_cached(n) ? cache_fetch(n) : 0;
+        if(0 == result) result = system_alloc(n);
         if(0 == result) result = oom_malloc(n);
         return result;
     }
 
     static void deallocate(void* p, size_t n)
+    {
+        if(!is_cached(n) || !cache_put(p, n))
+            system_free(p, n);
+    }
+
+    static void * reallocate(void *p, size_t old_size, size_t new_size);
+
+    // 配置起始地址按 align 对齐的空间，align 必须是 2 的幂
+    static void * allocate_aligned(size_t n, size_t align)
+    {
+        void * result = 0;
+        // posix_memalign 要求 align 至少为 sizeof(void*)
+        if(align < sizeof(void *)) align = sizeof(void *);
+        if(0 != posix_memalign(&result, align, n)) result = oom_malloc_aligned(n, align);
+        return result;
+    }
+
+    static void deallocate_aligned(void * p, size_t /* n */, size_t /* align */)
     {
         free(p);
     }
 
-    static void * reallocate(void *p, size_t /* old size*/, size_t new_size)
+    // 配置 n 个字节时实际得到的字节数
+    static size_t good_size(size_t n)
     {
-        p = realloc(p, new_size);
-        if(0 == p) p = oom_realloc(p, new_size);
-        return p;
+#ifdef __STL_HAS_MMAP
+        if(is_mapped(n))
+            return map_length(n) - __MAP_HEADER;
+#endif
+        return block_size(n);
     }
 
+    // 将缓存的空闲大区块全部归还给系统，返回归还的字节数
+    static size_t trim();
+
     /**
      *  基于set_new_handler().
      *  out_of_memory_handler()
@@ -90,21 +552,235 @@ public:
 template<int inst>
 void (* __malloc_alloc_template<inst>::__malloc_alloc_oom_handler)() = 0;
 
+template<int inst>
+void * __malloc_alloc_template<inst>::large_free[__NLARGELISTS] = { 0 };
+
+template<int inst>
+size_t __malloc_alloc_template<inst>::cached_bytes = 0;
+
+#ifdef __STL_THREADS
+template<int inst>
+std::mutex __malloc_alloc_template<inst>::large_lock;
+#endif
+
+#ifdef __STL_HAS_MMAP
+template<int inst>
+typename __malloc_alloc_template<inst>::map_header * __malloc_alloc_template<inst>::map_cache = 0;
+#endif
+
 /**
  *  malloc_alloc_template
- *  oom_alloc等函数定义
+ *  缓存、系统接口与oom_alloc等函数定义
 */
+template<int inst>
+void * __malloc_alloc_template<inst>::cache_fetch(size_t n)
+{
+    size_t i = large_index(n);
+#ifdef __STL_THREADS
+    std::lock_guard<std::mutex> guard(large_lock);
+#endif
+    void * result = large_free[i];
+    if(0 != result) {
+        large_free[i] = *(void **)result;
+        cached_bytes -= large_size(i);
+    }
+    return result;
+}
+
+template<int inst>
+bool __malloc_alloc_template<inst>::cache_put(void * p, size_t n)
+{
+    size_t i = large_index(n);
+#ifdef __STL_THREADS
+    std::lock_guard<std::mutex> guard(large_lock);
+#endif
+    if(cached_bytes + large_size(i) > (size_t)__STL_LARGE_CACHE_BYTES)
+        return false;
+    *(void **)p = large_free[i];
+    large_free[i] = p;
+    cached_bytes += large_size(i);
+    return true;
+}
+
+#ifdef __STL_HAS_MMAP
+template<int inst>
+void * __malloc_alloc_template<inst>::map_alloc(size_t n)
+{
+    size_t len = map_length(n);
+    {
+#ifdef __STL_THREADS
+        std::lock_guard<std::mutex> guard(large_lock);
+#endif
+        // 缓存中的映射不多，找出最合适的一个
+        map_header ** best = 0;
+        for(map_header ** cur = &map_cache; 0 != *cur; cur = &(*cur)->next) {
+            size_t l = (*cur)->length;
+            if(l >= len && l / 2 <= len && (0 == best || l < (*best)->length))
+                best = cur;
+        }
+        if(0 != best) {
+            map_header * h = *best;
+            *best = h->next;
+            cached_bytes -= h->length;
+            return (char *)h + __MAP_HEADER;
+        }
+    }
+    void * raw = mmap(0, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(MAP_FAILED == raw) return 0;
+    map_header * h = (map_header *)raw;
+    h->length = len;
+    return (char *)h + __MAP_HEADER;
+}
+
+template<int inst>
+void __malloc_alloc_template<inst>::map_free(void * p)
+{
+    map_header * h = header(p);
+    {
+#ifdef __STL_THREADS
+        std::lock_guard<std::mutex> guard(large_lock);
+#endif
+        if(cached_bytes + h->length <= (size_t)__STL_LARGE_CACHE_BYTES) {
+            h->next = map_cache;
+            map_cache = h;
+            cached_bytes += h->length;
+            return;
+        }
+    }
+    munmap(h, h->length);
+}
+
+template<int inst>
+void * __malloc_alloc_template<inst>::map_resize(void * p, size_t new_size)
+{
+    map_header * h = header(p);
+    size_t len = map_length(new_size);
+    // 映射够用并且没有浪费一半以上时原地返回
+    if(h->length >= len && h->length / 2 <= len)
+        return p;
+#ifdef MREMAP_MAYMOVE
+    // 通过修改页表增长或缩小映射，不复制内容
+    void * raw = mremap(h, h->length, len, MREMAP_MAYMOVE);
+    if(MAP_FAILED == raw) return 0;
+    h = (map_header *)raw;
+    h->length = len;
+    return (char *)h + __MAP_HEADER;
+#else
+    return 0;
+#endif
+}
+#endif
+
+template<int inst>
+void * __malloc_alloc_template<inst>::system_alloc(size_t n)
+{
+#ifdef __STL_HAS_MMAP
+    if(is_mapped(n))
+        return map_alloc(n);
+#endif
+    return malloc(block_size(n));
+}
+
+template<int inst>
+void __malloc_alloc_template<inst>::system_free(void * p, size_t n)
+{
+#ifdef __STL_HAS_MMAP
+    if(is_mapped(n)) {
+        map_free(p);
+        return;
+    }
+#endif
+    free(p);
+}
+
+template<int inst>
+void * __malloc_alloc_template<inst>::reallocate(void *p, size_t old_size, size_t new_size)
+{
+    if(!is_mapped(old_size) && !is_mapped(new_size)) {
+        if(block_size(old_size) == block_size(new_size))
+            return p;
+        // 缓存中有新类别的区块时优先使用，它的页面已经就绪，复制比缺页更便宜
+        void * result = is_cached(new_size) ? cache_fetch(new_size) : 0;
+        if(0 != result) {
+            memcpy(result, p, old_size < new_size ? old_size : new_size);
+            deallocate(p, old_size);
+            return result;
+        }
+        // realloc 失败时原空间仍然有效，交给 oom_realloc 继续尝试
+        result = realloc(p, block_size(new_size));
+        if(0 == result) result = oom_realloc(p, block_size(new_size));
+        return result;
+    }
+#ifdef __STL_HAS_MMAP
+    if(is_mapped(old_size) && is_mapped(new_size)) {
+        void * result = map_resize(p, new_size);
+        if(0 != result) return result;
+    }
+#endif
+    // 跨越 mmap 的界限，或者 mremap 失败
+    void * result = allocate(new_size);
+    memcpy(result, p, old_size < new_size ? old_size : new_size);
+    deallocate(p, old_size);
+    return result;
+}
+
+template<int inst>
+size_t __malloc_alloc_template<inst>::trim()
+{
+    void * lists[__NLARGELISTS];
+    size_t released;
+#ifdef __STL_HAS_MMAP
+    map_header * maps;
+#endif
+    {
+        // 先摘下所有缓存链表，释放时不持有锁
+#ifdef __STL_THREADS
+        std::lock_guard<std::mutex> guard(large_lock);
+#endif
+        for(int i = 0; i < __NLARGELISTS; ++i) {
+            lists[i] = large_free[i];
+            large_free[i] = 0;
+        }
+#ifdef __STL_HAS_MMAP
+        maps = map_cache;
+        map_cache = 0;
+#endif
+        released = cached_bytes;
+        cached_bytes = 0;
+    }
+    for(int i = 0; i < __NLARGELISTS; ++i) {
+        while(0 != lists[i]) {
+            void * next = *(void **)lists[i];
+            free(lists[i]);
+            lists[i] = next;
+        }
+    }
+#ifdef __STL_HAS_MMAP
+    while(0 != maps) {
+        map_header * next = maps->next;
+        munmap(maps, maps->length);
+        maps = next;
+    }
+#endif
+    return released;
+}
+
 template<int inst>
 void * __malloc_alloc_template<inst>::oom_malloc(size_t n)
 {
     void (* my_malloc_handler) ();
     void * result;
 
+    // 先归还缓存的空闲大区块再试一次
+    if(trim() > 0) {
+        result = system_alloc(n);
+        if(result) return result;
+    }
     for(;;) {   //不断尝试释放、配置、再释放、再配置
         my_malloc_handler = __malloc_alloc_oom_handler;
         if(0 == my_malloc_handler) { __THROW_BAD_ALLOC; }
         (*my_malloc_handler)();     //调用处理程序释放内存
-        result = malloc(n);
+        result = system_alloc(n);
         if(result) return result;
     }
 }
@@ -115,6 +791,10 @@ void * __malloc_alloc_template<inst>::oom_realloc(void* p, size_t n)
     void (* my_malloc_handler) ();
     void * result;
 
+    if(trim() > 0) {
+        result = realloc(p, n);
+        if(result) return result;
+    }
     for(;;) {
         my_malloc_handler = __malloc_alloc_oom_handler;
         if(0 == my_malloc_handler) { __THROW_BAD_ALLOC; }
@@ -124,28 +804,273 @@ void * __malloc_alloc_template<inst>::oom_realloc(void* p, size_t n)
     }
 }
 
+template<int inst>
+void * __malloc_alloc_template<inst>::oom_malloc_aligned(size_t n, size_t align)
+{
+    void (* my_malloc_handler) ();
+    void * result;
+
+    if(trim() > 0 && 0 == posix_memalign(&result, align, n))
+        return result;
+    for(;;) {
+        my_malloc_handler = __malloc_alloc_oom_handler;
+        if(0 == my_malloc_handler) { __THROW_BAD_ALLOC; }
+        (*my_malloc_handler)();
+        if(0 == posix_memalign(&result, align, n)) return result;
+    }
+}
+
 // 实例化一个inst为0的版本
 typedef __malloc_alloc_template<0> malloc_alloc;
 
 
 /**
  *  第二级配置器
- *  二级内存配置器只配置小于128 betys的空间，超过128 betys的空间交给一级配置分配
- *  为了便于管理分配的空间都为8的倍数例如：8，16，24，.....，128;
- *  用一个free_list_link连接各个大小的空间
+ *  二级内存配置器只配置不超过 __MAX_BYTES 的空间，超过 __MAX_BYTES 的空间交给一级配置分配
+ *  分配的空间按大小类别(size class)管理，每个类别用一个free_list_link连接各个大小的空间：
+ *      第一层：不超过128 bytes 的空间为8的倍数，例如：8，16，24，.....，128;
+ *      第二层：128 bytes 以上的每个区间 (2^k, 2^(k+1)] 等分为 __STL_POOL_TIER_STEPS 个类别，
+ *             默认为 160，192，224，256，320，.....，4096，浪费的空间不超过 25%
+ *  __STL_POOL_MAX_BYTES 设置池化的上限(2 的幂，至少为 128，默认 4096)，设为 128 即为原先的单层配置；
+ *  第二层的区块按 __STL_POOL_SLAB_BYTES 大小的 slab 批量切分。
  *  
+ *  定义 __STL_THREADS 后进入线程安全模式：
+ *  每个线程持有一份自己的 free list 缓存(thread_cache)，分配与释放只操作本线程缓存，不需要加锁；
+ *  原先的 free_list 与 chunk_alloc() 内存池成为所有线程共享的中心内存池，由 central_lock 保护，
+ *  线程缓存为空或积压过多时才加锁与中心内存池成批交换区块。
+ *  区块释放时归还到释放者所在线程的缓存，因此在一个线程分配、在另一个线程释放的区块同样安全。
 */
+#ifndef __STL_POOL_MAX_BYTES
+#define __STL_POOL_MAX_BYTES 4096
+#endif
+
+#ifndef __STL_POOL_TIER_STEPS
+#define __STL_POOL_TIER_STEPS 4
+#endif
+
+#ifndef __STL_POOL_SLAB_BYTES
+#define __STL_POOL_SLAB_BYTES (4 * 4096)
+#endif
+
+// 编译期求 log2(n)，n 为 2 的幂
+constexpr int __pool_log2(size_t n) { return n <= 1 ? 0 : 1 + __pool_log2(n >> 1); }
+
 enum { __ALIGN = 8 };
-enum { __MAX_BYTES = 128 };
-enum { __NFREELISTS = __MAX_BYTES / __ALIGN };
+enum { __SMALL_BYTES = 128 };       // 第一层的上限
+enum { __MAX_BYTES = __STL_POOL_MAX_BYTES };
+enum { __NSMALLLISTS = __SMALL_BYTES / __ALIGN };
+enum { __NFREELISTS = __NSMALLLISTS
+                      + __STL_POOL_TIER_STEPS * (__pool_log2(__MAX_BYTES) - __pool_log2(__SMALL_BYTES)) };
+
+static_assert((size_t)__MAX_BYTES >= (size_t)__SMALL_BYTES && (__MAX_BYTES & (__MAX_BYTES - 1)) == 0,
+              "__STL_POOL_MAX_BYTES must be a power of two no less than 128");
+static_assert(__STL_POOL_TIER_STEPS >= 1 && __STL_POOL_TIER_STEPS <= __SMALL_BYTES / __ALIGN
+              && (__STL_POOL_TIER_STEPS & (__STL_POOL_TIER_STEPS - 1)) == 0,
+              "__STL_POOL_TIER_STEPS must be a power of two between 1 and 16");
 
-//与第一级配置器一样模板参数完全没有发挥作用
+/**
+ *  大小类别的计算
+ *  index() 找出能容纳 bytes 的最小类别，size() 返回类别的区块大小
+*/
+struct __pool_size_class {
+    static size_t index(size_t bytes) {
+        if(bytes <= __SMALL_BYTES)
+            return (bytes + __ALIGN - 1) / __ALIGN - 1;
+        // 2^k < bytes <= 2^(k+1)
+        size_t k = highest_bit(bytes - 1);
+        size_t step = ((size_t)1 << k) / __STL_POOL_TIER_STEPS;
+        return __NSMALLLISTS + (k - __pool_log2(__SMALL_BYTES)) * __STL_POOL_TIER_STEPS
+               + (bytes - 1 - ((size_t)1 << k)) / step;
+    }
+
+    static size_t size(size_t i) {
+        if(i < __NSMALLLISTS)
+            return (i + 1) * __ALIGN;
+        i -= __NSMALLLISTS;
+        size_t base = (size_t)__SMALL_BYTES << (i / __STL_POOL_TIER_STEPS);
+        return base + (i % __STL_POOL_TIER_STEPS + 1) * (base / __STL_POOL_TIER_STEPS);
+    }
+
+    // 不超过 bytes 的最大类别，bytes 至少为 __ALIGN
+    static size_t floor_index(size_t bytes) {
+        if(bytes > __MAX_BYTES)
+            return __NFREELISTS - 1;
+        size_t i = index(bytes);
+        return size(i) > bytes ? i - 1 : i;
+    }
+
+    // refill 一次切分的区块数量，第一层为 20 个，第二层按 slab 大小切分
+    static int refill_count(size_t bytes) {
+        if(bytes <= __SMALL_BYTES)
+            return 20;
+        size_t n = __STL_POOL_SLAB_BYTES / bytes;
+        return n < 2 ? 2 : (n > 20 ? 20 : (int)n);
+    }
+
+    static size_t align_up(size_t bytes) {
+        return ( (bytes + __ALIGN - 1) & (~(__ALIGN - 1)) );
+    }
+
+    static size_t highest_bit(size_t x) {
+#ifdef __GNUC__
+        return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(x);
+#else
+        size_t k = 0;
+        while(x >>= 1) ++k;
+        return k;
+#endif
+    }
+};
+
+/**
+ *  内存池统计信息，由 __default_alloc_template<inst>::get_stats() 填写快照
+ *  数组按大小类别索引，第 i 个类别的区块大小为 block_size(i)
+ *  线程模式下各线程的计数先累积在线程缓存中，在该线程与中心内存池交换区块时汇总，
+ *  因此快照中其他线程的计数以它们最近一次与中心内存池交换区块时为准
+*/
+struct alloc_stats {
+    size_t allocs[__NFREELISTS];        // allocate 次数
+    size_t deallocs[__NFREELISTS];      // deallocate 次数
+    size_t refills[__NFREELISTS];       // refill 次数(线程模式下为向中心内存池批量申请的次数)
+    size_t free_blocks[__NFREELISTS];   // 挂在中心 free list 上的空闲区块数量
+    size_t cached_blocks[__NFREELISTS]; // 挂在各线程缓存上的空闲区块数量，非线程模式下为 0
+
+    size_t large_allocs;        // 超过 __MAX_BYTES 交给第一级配置器的 allocate 次数
+    size_t large_deallocs;      // 超过 __MAX_BYTES 交给第一级配置器的 deallocate 次数
+    size_t chunk_allocs;        // chunk_alloc 调用 malloc 补充内存池的次数
+    size_t freelist_reclaims;   // malloc 失败后从更大的 free list 中回收区块的次数
+    size_t malloc_fallbacks;    // malloc 失败后回退到 malloc_alloc 的次数
+    size_t heap_size;           // 内存池当前向系统持有的字节数
+    size_t pool_bytes;          // 内存池中尚未切分成区块的字节数
+    size_t trims;               // trim() 调用次数
+    size_t trimmed_bytes;       // trim() 归还给系统的字节数
+
+    static size_t block_size(int i) { return __pool_size_class::size(i); }
+
+    // 第 i 个类别闲置在 free list 与线程缓存中的字节数
+    size_t idle_bytes(int i) const { return (free_blocks[i] + cached_blocks[i]) * block_size(i); }
+
+    // 内存池中所有闲置的字节数
+    size_t idle_bytes() const {
+        size_t result = pool_bytes;
+        for(int i = 0; i < __NFREELISTS; ++i)
+            result += idle_bytes(i);
+        return result;
+    }
+};
+
+/**
+ *  内存池 chunk 的来源
+ *  chunk_alloc() 通过 __pool_chunk_source<inst>::type 向系统申请 chunk，trim() 通过它归还 chunk
+ *  来源类型需要提供：
+ *      static void * allocate(size_t & bytes);     // bytes 可以被上调，返回实际得到的大小
+ *      static void deallocate(void * p, size_t bytes);
+ *  默认使用 malloc/free，inst 为 __HUGEPAGE_POOL_INST 时使用 mmap 映射的大页区域，
+ *  也可以为自己的 inst 特化 __pool_chunk_source 来提供其他来源
+*/
+struct __malloc_chunk_source {
+    static void * allocate(size_t & bytes) { return malloc(bytes); }
+    static void deallocate(void * p, size_t) { free(p); }
+};
+
+#ifdef __STL_HAS_MMAP
+
+#ifndef __STL_HUGEPAGE_REGION_BYTES
+#define __STL_HUGEPAGE_REGION_BYTES (64 * 1024 * 1024)
+#endif
+
+/**
+ *  以 mmap 映射按 2MB 对齐的大块区域，并提示内核使用透明大页(MADV_HUGEPAGE)
+ *  内存池的 chunk 从当前区域中依次切出，rb_tree / hashtable 的节点因此集中在少数大页中，减少 TLB miss
+ *  不小于半个区域的 chunk 单独映射；chunk 大小按页上调，trim() 时直接 munmap 归还
+ *  只会在内存池持有中心锁时被调用，因此不需要自己的锁
+*/
+template<int inst>
+class __mmap_chunk_source {
+private:
+    enum { __HUGE_PAGE_BYTES = 2 * 1024 * 1024 };
+    static char * region_cur;   // 当前区域中尚未切出的部分
+    static char * region_end;
+
+    static size_t round_up(size_t bytes, size_t align) {
+        return (bytes + align - 1) & ~(align - 1);
+    }
+
+    // 映射 bytes 大小且起始地址按 2MB 对齐的区域
+    static char * map_aligned(size_t bytes) {
+        // 多映射 2MB 以便对齐起始地址，再把两端多余的部分 munmap
+        size_t len = bytes + __HUGE_PAGE_BYTES;
+        void * raw = mmap(0, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(MAP_FAILED == raw) return 0;
+        char * first = (char *)raw;
+        char * aligned = (char *)round_up((size_t)first, __HUGE_PAGE_BYTES);
+        if(aligned != first)
+            munmap(first, aligned - first);
+        if(first + len != aligned + bytes)
+            munmap(aligned + bytes, (first + len) - (aligned + bytes));
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+        return aligned;
+    }
+
+public:
+    static void * allocate(size_t & bytes) {
+        bytes = round_up(bytes, (size_t)sysconf(_SC_PAGESIZE));
+        if(bytes >= __STL_HUGEPAGE_REGION_BYTES / 2) {
+            // 大 chunk 单独映射，大小上调到 2MB 的倍数
+            bytes = round_up(bytes, __HUGE_PAGE_BYTES);
+            return map_aligned(bytes);
+        }
+        if((size_t)(region_end - region_cur) < bytes) {
+            // 当前区域不够，归还剩余的部分并映射新的区域
+            if(region_cur != region_end)
+                munmap(region_cur, region_end - region_cur);
+            region_cur = region_end = 0;
+            char * region = map_aligned(__STL_HUGEPAGE_REGION_BYTES);
+            if(0 == region) return 0;
+            region_cur = region;
+            region_end = region + __STL_HUGEPAGE_REGION_BYTES;
+        }
+        char * result = region_cur;
+        region_cur += bytes;
+        return result;
+    }
+
+    static void deallocate(void * p, size_t bytes) {
+        munmap(p, bytes);
+    }
+};
+
+template<int inst>
+char * __mmap_chunk_source<inst>::region_cur = 0;
+
+template<int inst>
+char * __mmap_chunk_source<inst>::region_end = 0;
+
+#endif
+
+enum { __HUGEPAGE_POOL_INST = 1 };
+
+template<int inst>
+struct __pool_chunk_source {
+    typedef __malloc_chunk_source type;
+};
+
+#ifdef __STL_HAS_MMAP
+template<>
+struct __pool_chunk_source<__HUGEPAGE_POOL_INST> {
+    typedef __mmap_chunk_source<__HUGEPAGE_POOL_INST> type;
+};
+#endif
+
+// inst 决定内存池 chunk 的来源，见 __pool_chunk_source
 template<int inst>
 class __default_alloc_template {
 private:
-    //将bytes 上调至8的倍数
+    //将bytes 上调至所属类别的区块大小
     static size_t ROUND_UP(size_t bytes) {
-        return ( (bytes + __ALIGN - 1) & (~(__ALIGN - 1)) );
+        return __pool_size_class::size(__pool_size_class::index(bytes));
     }
 
     // 使用union数据类型用作于内存地址
@@ -156,11 +1081,11 @@ private:
     };
 
 private:
-    // 16 free-lists
+    // 每个大小类别一个 free list
     static obj * volatile free_list[__NFREELISTS];
     // 根据bytes选择合适的内存块
     static size_t FREELIST_INDEX(size_t bytes) {
-        return ( (bytes + __ALIGN - 1)) / __ALIGN - 1;
+        return __pool_size_class::index(bytes);
     }
 
     //返回一个大小为n的对象，并可能加入大小为 n 的其他区块到 free_list 中
@@ -170,15 +1095,95 @@ private:
     //如果内存空间紧张，则配置的数量可能小于 nobjs 
     static char *chunk_alloc(size_t size, int &nobjs);
 
+    typedef typename __pool_chunk_source<inst>::type chunk_source;
+
     //Chunk allocation state
     static char* start_free;    // 内存池起始位置
     static char* end_free;      // 内存池结束位置
     static size_t heap_size;
 
+    // 每个向系统申请的 chunk 头部都有一个 chunk_header，所有 chunk 串成一个链表
+    // chunk_header 的大小为 __ALIGN 的倍数，保证切分出的区块仍然按 8 bytes 对齐
+    struct chunk_header {
+        chunk_header * next;
+        size_t size;        // chunk 中可切分的字节数，不包括 chunk_header
+        bool from_malloc_alloc;     // chunk 来源失败后改由 malloc_alloc 配置
+    };
+    static_assert(sizeof(chunk_header) % __ALIGN == 0, "chunk_header must keep blocks aligned");
+    static chunk_header * chunk_list;
+
+    // 在按地址排好序的 chunks 中找出包含 p 的 chunk
+    static size_t find_chunk(chunk_header ** chunks, size_t n, const char * p);
+    static int chunk_address_compare(const void * a, const void * b);
+
+    // 第一级配置器内存不足时的处理函数，先 trim() 内存池，归还不了内存时交给之前的处理函数
+    static void oom_reclaim();
+    static void (* prev_oom_handler) ();
+
+    // 运行计数，free_blocks / heap_size / pool_bytes 在取快照时现场统计
+    static alloc_stats counters;
+
+#ifdef __STL_THREADS
+    // 线程缓存一次与中心内存池交换 __pool_size_class::refill_count() 个区块，
+    // 单个 free list 上积压超过它的两倍时归还一批
+
+    // 每个线程私有的 free list 缓存
+    struct thread_cache {
+        obj * free_list[__NFREELISTS];
+        size_t length[__NFREELISTS];    // 每个 free list 上的区块数量
+
+        // 尚未汇总到 counters 的计数
+        size_t allocs[__NFREELISTS];
+        size_t deallocs[__NFREELISTS];
+        size_t large_allocs;
+        size_t large_deallocs;
+
+        thread_cache();
+        // 线程退出时把缓存的区块全部归还中心内存池，之后缓存保持为空
+        ~thread_cache();
+    };
+
+    // 中心内存池的锁，只在线程缓存与中心内存池交换区块时使用
+    // 内存不足时 chunk_alloc() 会在持有锁的情况下经 oom_reclaim() 进入 trim()，因此使用可重入锁
+    static std::recursive_mutex central_lock;
+    static thread_local thread_cache tcache;
+
+    // 加锁后从中心内存池取出至多 nobjs 个大小为 n 的区块，返回以 0 结尾的链表
+    // nobjs 通过引用传递，返回实际取出的数量
+    static obj * central_fetch(thread_cache & tc, size_t n, int &nobjs);
+    // 加锁后将 [first, last] 链表上 count 个大小为 n 的区块归还中心内存池
+    static void central_release(thread_cache & tc, size_t n, obj * first, obj * last, size_t count);
+    // 将线程缓存中的计数汇总到 counters，调用前必须持有 central_lock
+    static void sync_stats(thread_cache & tc);
+    // 将线程缓存中的所有区块归还中心内存池
+    static void flush_cache(thread_cache & tc);
+#endif
+
 public:
     static void* allocate(size_t n);
     static void deallocate(void *p, size_t n);
-    static void* reallocate(void *p, size_t, size_t new_size);
+    // 重新配置，内容按位搬移
+    static void* reallocate(void *p, size_t old_size, size_t new_size);
+
+    // 配置 n 个字节时实际得到的字节数，即所在类别的区块大小
+    static size_t good_size(size_t n) {
+        return n > (size_t) __MAX_BYTES ? malloc_alloc::good_size(n) : ROUND_UP(n);
+    }
+
+    // 一次配置 / 释放 count 个大小为 n 的区块，整批只查找一次 free list、最多加锁一次
+    static void allocate_batch(size_t n, size_t count, void ** out);
+    static void deallocate_batch(size_t n, size_t count, void ** p);
+
+    // 统计信息接口
+    static void get_stats(alloc_stats & s);     // 取得当前统计快照
+    static void reset_stats();                  // 计数清零，内存池状态(空闲区块、heap_size)不受影响
+    static void dump_stats(std::ostream & os = std::cerr);  // 以表格形式输出统计信息
+
+    // 将内存池中完全空闲的 chunk 归还给系统，返回归还的字节数
+    // 线程模式下只会先清空调用线程自己的缓存，其他线程缓存中的区块仍视为在使用
+    static size_t trim();
+    // 将 oom_reclaim() 设置为第一级配置器的内存不足处理函数，原先的处理函数在 trim() 无效时被调用
+    static void install_oom_handler();
 };
 
 //__default_alloc初始值设置
@@ -193,21 +1198,167 @@ size_t __default_alloc_template<inst>::heap_size = 0;
 
 template<int inst>
 typename __default_alloc_template<inst>::obj * volatile
-__default_alloc_template<inst>::free_list[__NFREELISTS] = 
-{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+__default_alloc_template<inst>::free_list[__NFREELISTS] = { 0 };
+
+template<int inst>
+alloc_stats __default_alloc_template<inst>::counters;
+
+template<int inst>
+typename __default_alloc_template<inst>::chunk_header *
+__default_alloc_template<inst>::chunk_list = 0;
+
+template<int inst>
+void (* __default_alloc_template<inst>::prev_oom_handler)() = 0;
+
+#ifdef __STL_THREADS
+template<int inst>
+std::recursive_mutex __default_alloc_template<inst>::central_lock;
+
+template<int inst>
+thread_local typename __default_alloc_template<inst>::thread_cache
+__default_alloc_template<inst>::tcache;
+
+template<int inst>
+__default_alloc_template<inst>::thread_cache::thread_cache() : large_allocs(0), large_deallocs(0)
+{
+    for(int i = 0; i < __NFREELISTS; ++i) {
+        free_list[i] = 0;
+        length[i] = 0;
+        allocs[i] = 0;
+        deallocs[i] = 0;
+    }
+}
+
+template<int inst>
+__default_alloc_template<inst>::thread_cache::~thread_cache()
+{
+    flush_cache(*this);
+}
+
+template<int inst>
+void __default_alloc_template<inst>::flush_cache(thread_cache & tc)
+{
+    std::lock_guard<std::recursive_mutex> guard(central_lock);
+    for(int i = 0; i < __NFREELISTS; ++i) {
+        obj * first = tc.free_list[i];
+        if(0 == first) continue;
+        obj * last = first;
+        while(0 != last->free_list_link) last = last->free_list_link;
+        central_release(tc, __pool_size_class::size(i), first, last, tc.length[i]);
+        tc.free_list[i] = 0;
+        tc.length[i] = 0;
+    }
+    sync_stats(tc);
+}
+
+template<int inst>
+void __default_alloc_template<inst>::sync_stats(thread_cache & tc)
+{
+    for(int i = 0; i < __NFREELISTS; ++i) {
+        counters.allocs[i] += tc.allocs[i];
+        counters.deallocs[i] += tc.deallocs[i];
+        // 分配出去的区块离开线程缓存，释放回来的区块进入线程缓存
+        counters.cached_blocks[i] += tc.deallocs[i];
+        counters.cached_blocks[i] -= tc.allocs[i];
+        tc.allocs[i] = 0;
+        tc.deallocs[i] = 0;
+    }
+    counters.large_allocs += tc.large_allocs;
+    counters.large_deallocs += tc.large_deallocs;
+    tc.large_allocs = 0;
+    tc.large_deallocs = 0;
+}
+
+template<int inst>
+typename __default_alloc_template<inst>::obj *
+__default_alloc_template<inst>::central_fetch(thread_cache & tc, size_t n, int &nobjs)
+{
+    std::lock_guard<std::recursive_mutex> guard(central_lock);
+    obj * volatile * my_free_list = free_list + FREELIST_INDEX(n);
+    obj * result = *my_free_list;
+    obj * current_obj, * next_obj;
+    int i;
+
+    sync_stats(tc);
+    ++counters.refills[FREELIST_INDEX(n)];
+
+    if(0 != result) {
+        // 中心 free list 上还有区块，直接摘下至多 nobjs 个
+        current_obj = result;
+        for(i = 1; i < nobjs && 0 != current_obj->free_list_link; ++i)
+            current_obj = current_obj->free_list_link;
+        *my_free_list = current_obj->free_list_link;
+        current_obj->free_list_link = 0;
+        nobjs = i;
+        counters.cached_blocks[FREELIST_INDEX(n)] += nobjs;
+        return result;
+    }
+
+    // 中心 free list 也为空，从内存池切出一段连续空间并串联成链表
+    result = (obj *)chunk_alloc(n, nobjs);
+    next_obj = result;
+    for(i = 1; ; ++i) {
+        current_obj = next_obj;
+        next_obj = (obj *)((char *)next_obj + n);
+        if(nobjs == i) {
+            current_obj->free_list_link = 0;
+            break;
+        }
+        current_obj->free_list_link = next_obj;
+    }
+    counters.cached_blocks[FREELIST_INDEX(n)] += nobjs;
+    return result;
+}
+
+template<int inst>
+void __default_alloc_template<inst>::central_release(thread_cache & tc, size_t n, obj * first, obj * last, size_t count)
+{
+    std::lock_guard<std::recursive_mutex> guard(central_lock);
+    obj * volatile * my_free_list = free_list + FREELIST_INDEX(n);
+    sync_stats(tc);
+    last->free_list_link = *my_free_list;
+    *my_free_list = first;
+    counters.cached_blocks[FREELIST_INDEX(n)] -= count;
+}
+#endif
 
 template<int inst>
 void * __default_alloc_template<inst>::allocate(size_t n)
 {
+#ifndef __STL_THREADS
     obj * volatile * my_free_list;
+#endif
     obj * result;
 
-    //大于128 bytes调用第一级配置器
+    //大于 __MAX_BYTES 调用第一级配置器
     if(n > (size_t) __MAX_BYTES ) {
+#ifdef __STL_THREADS
+        ++tcache.large_allocs;
+#else
+        ++counters.large_allocs;
+#endif
         return (malloc_alloc::allocate(n));
     }
 
+#ifdef __STL_THREADS
+    // 线程模式下先从本线程缓存中取区块，不需要加锁
+    thread_cache & tc = tcache;
+    size_t index = FREELIST_INDEX(n);
+    result = tc.free_list[index];
+    if(0 == result) {
+        // 本线程缓存为空，向中心内存池批量申请区块
+        int nobjs = __pool_size_class::refill_count(ROUND_UP(n));
+        result = central_fetch(tc, ROUND_UP(n), nobjs);
+        tc.length[index] += nobjs - 1;
+    } else {
+        --tc.length[index];
+    }
+    tc.free_list[index] = result->free_list_link;
+    ++tc.allocs[index];
+    return result;
+#else
     //找到最合适的空间大小
+    ++counters.allocs[FREELIST_INDEX(n)];
     my_free_list = free_list + FREELIST_INDEX(n);
     result = *my_free_list;
     if(0 == result) {
@@ -218,22 +1369,364 @@ void * __default_alloc_template<inst>::allocate(size_t n)
     // 取下free list 并调整
     *my_free_list = result->free_list_link;
     return result;
+#endif
 }
 
 template<int inst>
 void __default_alloc_template<inst>::deallocate(void *p, size_t n)
 {
     obj *q = (obj *)p;
+#ifndef __STL_THREADS
     obj * volatile *my_free_list;
-    if(n > (size_t) 128) {
+#endif
+    if(n > (size_t) __MAX_BYTES) {
+#ifdef __STL_THREADS
+        ++tcache.large_deallocs;
+#else
+        ++counters.large_deallocs;
+#endif
         malloc_alloc::deallocate(p, n);
         return;
     }
+
+#ifdef __STL_THREADS
+    // 区块归还到释放者所在线程的缓存，无论它最初由哪个线程分配
+    thread_cache & tc = tcache;
+    size_t index = FREELIST_INDEX(n);
+    q->free_list_link = tc.free_list[index];
+    tc.free_list[index] = q;
+    ++tc.deallocs[index];
+    int batch = __pool_size_class::refill_count(ROUND_UP(n));
+    if(++tc.length[index] > (size_t)(2 * batch)) {
+        // 积压过多(例如一个线程生产、另一个线程消费)，把一批区块归还中心内存池供其他线程复用
+        obj * last = q;
+        for(int i = 1; i < batch; ++i)
+            last = last->free_list_link;
+        tc.free_list[index] = last->free_list_link;
+        tc.length[index] -= batch;
+        central_release(tc, ROUND_UP(n), q, last, batch);
+    }
+#else
     // 寻找对应的free_list
+    ++counters.deallocs[FREELIST_INDEX(n)];
     my_free_list = free_list + FREELIST_INDEX(n);
     // 调整free list
     q->free_list_link = (*my_free_list);
     *my_free_list = q;
+#endif
+}
+
+/**
+ *  重新配置
+ *  新旧大小都超过 __MAX_BYTES 时交给第一级配置器的 realloc()，大块空间可以原地扩展或由 mremap 搬移；
+ *  新旧大小属于同一个类别时区块本身就能容纳，直接返回 p；
+ *  其他情况配置新的区块，复制内容后释放旧区块
+*/
+template<int inst>
+void * __default_alloc_template<inst>::reallocate(void *p, size_t old_size, size_t new_size)
+{
+    if(old_size > (size_t) __MAX_BYTES && new_size > (size_t) __MAX_BYTES) {
+#ifdef __STL_THREADS
+        ++tcache.large_allocs;
+        ++tcache.large_deallocs;
+#else
+        ++counters.large_allocs;
+        ++counters.large_deallocs;
+#endif
+        return malloc_alloc::reallocate(p, old_size, new_size);
+    }
+    if(old_size <= (size_t) __MAX_BYTES && new_size <= (size_t) __MAX_BYTES
+       && ROUND_UP(old_size) == ROUND_UP(new_size))
+        return p;
+
+    void * result = allocate(new_size);
+    memcpy(result, p, old_size < new_size ? old_size : new_size);
+    deallocate(p, old_size);
+    return result;
+}
+
+template<int inst>
+void __default_alloc_template<inst>::allocate_batch(size_t n, size_t count, void ** out)
+{
+    size_t k = 0;
+    if(n > (size_t) __MAX_BYTES) {
+#ifdef __STL_THREADS
+        tcache.large_allocs += count;
+#else
+        counters.large_allocs += count;
+#endif
+        for(; k < count; ++k)
+            out[k] = malloc_alloc::allocate(n);
+        return;
+    }
+
+    size_t index = FREELIST_INDEX(n);
+#ifdef __STL_THREADS
+    // 先取本线程缓存中的区块，不够时向中心内存池一次申请剩下的数量
+    thread_cache & tc = tcache;
+    obj * result = tc.free_list[index];
+    for(; k < count && 0 != result; ++k, result = result->free_list_link)
+        out[k] = result;
+    tc.free_list[index] = result;
+    tc.length[index] -= k;
+    tc.allocs[index] += count;
+    while(k < count) {
+        int nobjs = (int)(count - k);
+        for(obj * p = central_fetch(tc, ROUND_UP(n), nobjs); 0 != p; p = p->free_list_link)
+            out[k++] = p;
+    }
+#else
+    counters.allocs[index] += count;
+    obj * result = free_list[index];
+    for(; k < count && 0 != result; ++k, result = result->free_list_link)
+        out[k] = result;
+    free_list[index] = result;
+    // free list 不够时直接从内存池切出剩下的区块，不经过 free list
+    while(k < count) {
+        int nobjs = (int)(count - k);
+        char * chunk = chunk_alloc(ROUND_UP(n), nobjs);
+        ++counters.refills[index];
+        for(int i = 0; i < nobjs; ++i)
+            out[k++] = chunk + i * ROUND_UP(n);
+    }
+#endif
+}
+
+template<int inst>
+void __default_alloc_template<inst>::deallocate_batch(size_t n, size_t count, void ** p)
+{
+    if(0 == count) return;
+    if(n > (size_t) __MAX_BYTES) {
+#ifdef __STL_THREADS
+        tcache.large_deallocs += count;
+#else
+        counters.large_deallocs += count;
+#endif
+        for(size_t k = 0; k < count; ++k)
+            malloc_alloc::deallocate(p[k], n);
+        return;
+    }
+
+    // 先把整批区块串成链表，再一次接到 free list 上
+    size_t index = FREELIST_INDEX(n);
+    obj * first = (obj *)p[0];
+    obj * last = first;
+    for(size_t k = 1; k < count; ++k) {
+        last->free_list_link = (obj *)p[k];
+        last = (obj *)p[k];
+    }
+#ifdef __STL_THREADS
+    thread_cache & tc = tcache;
+    last->free_list_link = tc.free_list[index];
+    tc.free_list[index] = first;
+    tc.deallocs[index] += count;
+    tc.length[index] += count;
+    size_t batch = __pool_size_class::refill_count(ROUND_UP(n));
+    if(tc.length[index] > 2 * batch) {
+        // 积压过多，只保留一批，其余一次归还中心内存池
+        size_t surplus = tc.length[index] - batch;
+        first = tc.free_list[index];
+        last = first;
+        for(size_t k = 1; k < surplus; ++k)
+            last = last->free_list_link;
+        tc.free_list[index] = last->free_list_link;
+        tc.length[index] = batch;
+        central_release(tc, ROUND_UP(n), first, last, surplus);
+    }
+#else
+    counters.deallocs[index] += count;
+    last->free_list_link = free_list[index];
+    free_list[index] = first;
+#endif
+}
+
+template<int inst>
+void __default_alloc_template<inst>::get_stats(alloc_stats & s)
+{
+#ifdef __STL_THREADS
+    std::lock_guard<std::recursive_mutex> guard(central_lock);
+    sync_stats(tcache);
+#endif
+    s = counters;
+    for(int i = 0; i < __NFREELISTS; ++i) {
+        size_t len = 0;
+        for(obj * p = free_list[i]; p != 0; p = p->free_list_link)
+            ++len;
+        s.free_blocks[i] = len;
+    }
+    s.heap_size = heap_size;
+    s.pool_bytes = end_free - start_free;
+}
+
+template<int inst>
+void __default_alloc_template<inst>::reset_stats()
+{
+#ifdef __STL_THREADS
+    std::lock_guard<std::recursive_mutex> guard(central_lock);
+    sync_stats(tcache);
+#endif
+    // cached_blocks 记录的是线程缓存的状态而不是计数，保留
+    for(int i = 0; i < __NFREELISTS; ++i) {
+        counters.allocs[i] = 0;
+        counters.deallocs[i] = 0;
+        counters.refills[i] = 0;
+    }
+    counters.large_allocs = 0;
+    counters.large_deallocs = 0;
+    counters.chunk_allocs = 0;
+    counters.freelist_reclaims = 0;
+    counters.malloc_fallbacks = 0;
+    counters.trims = 0;
+    counters.trimmed_bytes = 0;
+}
+
+template<int inst>
+void __default_alloc_template<inst>::dump_stats(std::ostream & os)
+{
+    alloc_stats s;
+    get_stats(s);
+    os << "size\tallocs\tdeallocs\trefills\tfree\tcached\tidle_bytes\n";
+    for(int i = 0; i < __NFREELISTS; ++i) {
+        if(0 == s.allocs[i] && 0 == s.free_blocks[i] && 0 == s.cached_blocks[i]) continue;
+        os << alloc_stats::block_size(i) << '\t' << s.allocs[i] << '\t' << s.deallocs[i] << '\t'
+           << s.refills[i] << '\t' << s.free_blocks[i] << '\t' << s.cached_blocks[i] << '\t'
+           << s.idle_bytes(i) << '\n';
+    }
+    os << "large allocs: " << s.large_allocs << ", large deallocs: " << s.large_deallocs << '\n'
+       << "heap size: " << s.heap_size << ", pool bytes: " << s.pool_bytes
+       << ", idle bytes: " << s.idle_bytes() << '\n'
+       << "chunk allocs: " << s.chunk_allocs << ", free list reclaims: " << s.freelist_reclaims
+       << ", malloc_alloc fallbacks: " << s.malloc_fallbacks << '\n'
+       << "trims: " << s.trims << ", trimmed bytes: " << s.trimmed_bytes << std::endl;
+}
+
+template<int inst>
+int __default_alloc_template<inst>::chunk_address_compare(const void * a, const void * b)
+{
+    const char * x = *(const char * const *)a;
+    const char * y = *(const char * const *)b;
+    return x < y ? -1 : (y < x ? 1 : 0);
+}
+
+template<int inst>
+size_t __default_alloc_template<inst>::find_chunk(chunk_header ** chunks, size_t n, const char * p)
+{
+    // 二分查找最后一个起始地址不大于 p 的 chunk
+    size_t first = 0, len = n;
+    while(len > 0) {
+        size_t half = len >> 1;
+        if((const char *)chunks[first + half] <= p) {
+            first += half + 1;
+            len -= half + 1;
+        } else {
+            len = half;
+        }
+    }
+    return first - 1;
+}
+
+/**
+ *  trim() 将完全空闲的 chunk 归还给系统
+ *  chunk 切分出的区块最终都会挂到某个 free list 上或者仍在使用，加上内存池剩余的空间，
+ *  一个 chunk 中空闲的字节数等于它的大小时，说明该 chunk 中没有区块在使用，可以整块释放
+*/
+template<int inst>
+size_t __default_alloc_template<inst>::trim()
+{
+#ifdef __STL_THREADS
+    std::lock_guard<std::recursive_mutex> guard(central_lock);
+    flush_cache(tcache);
+#endif
+    size_t nchunks = 0;
+    for(chunk_header * h = chunk_list; h != 0; h = h->next)
+        ++nchunks;
+    if(0 == nchunks) return 0;
+
+    // 按地址排序的 chunk 数组，以及每个 chunk 中的空闲字节数
+    chunk_header ** chunks = (chunk_header **)malloc(nchunks * (sizeof(chunk_header *) + sizeof(size_t)));
+    if(0 == chunks) return 0;
+    size_t * free_bytes = (size_t *)(chunks + nchunks);
+    size_t i = 0;
+    for(chunk_header * h = chunk_list; h != 0; h = h->next)
+        chunks[i++] = h;
+    qsort(chunks, nchunks, sizeof(chunk_header *), chunk_address_compare);
+    for(i = 0; i < nchunks; ++i)
+        free_bytes[i] = 0;
+
+    // 统计每个 chunk 中的空闲字节数
+    for(int k = 0; k < __NFREELISTS; ++k)
+        for(obj * p = free_list[k]; p != 0; p = p->free_list_link)
+            free_bytes[find_chunk(chunks, nchunks, (char *)p)] += alloc_stats::block_size(k);
+    if(start_free != end_free)
+        free_bytes[find_chunk(chunks, nchunks, start_free)] += end_free - start_free;
+
+    // 完全空闲的 chunk 用 (size_t)-1 标记
+    size_t released = 0;
+    for(i = 0; i < nchunks; ++i) {
+        if(free_bytes[i] == chunks[i]->size) {
+            free_bytes[i] = (size_t)-1;
+            released += chunks[i]->size;
+        }
+    }
+
+    if(released > 0) {
+        // 从 free list 中摘除位于待释放 chunk 中的区块
+        for(int k = 0; k < __NFREELISTS; ++k) {
+            obj * keep = 0;
+            obj * p = free_list[k];
+            while(p != 0) {
+                obj * next = p->free_list_link;
+                if(free_bytes[find_chunk(chunks, nchunks, (char *)p)] != (size_t)-1) {
+                    p->free_list_link = keep;
+                    keep = p;
+                }
+                p = next;
+            }
+            free_list[k] = keep;
+        }
+        if(start_free != end_free && free_bytes[find_chunk(chunks, nchunks, start_free)] == (size_t)-1)
+            start_free = end_free = 0;
+
+        // 从 chunk 链表中摘除并归还系统
+        chunk_header ** link = &chunk_list;
+        while(*link != 0) {
+            chunk_header * h = *link;
+            if(free_bytes[find_chunk(chunks, nchunks, (char *)h)] == (size_t)-1) {
+                *link = h->next;
+                if(h->from_malloc_alloc)
+                    malloc_alloc::deallocate(h, h->size + sizeof(chunk_header));
+                else
+                    chunk_source::deallocate(h, h->size + sizeof(chunk_header));
+            } else {
+                link = &h->next;
+            }
+        }
+        heap_size -= released;
+    }
+    free(chunks);
+    ++counters.trims;
+    counters.trimmed_bytes += released;
+    return released;
+}
+
+template<int inst>
+void __default_alloc_template<inst>::oom_reclaim()
+{
+    if(trim() > 0) return;
+    // 内存池中没有可以归还的内存，交给之前设置的处理函数
+    if(0 != prev_oom_handler) {
+        (*prev_oom_handler)();
+        return;
+    }
+    __THROW_BAD_ALLOC;
+}
+
+template<int inst>
+void __default_alloc_template<inst>::install_oom_handler()
+{
+    void (* old)() = malloc_alloc::set_malloc_handler(oom_reclaim);
+    if(old != oom_reclaim)
+        prev_oom_handler = old;
 }
 
 /**
@@ -242,11 +1735,11 @@ void __default_alloc_template<inst>::deallocate(void *p, size_t n)
  *  新的空间将取自内存池( 由chunk_alloc()维护 )，从chunk_alloc()中取出的是一块连续的内存空间
  *  取出后自己进行将空间连接成 free list
 */
-// 假设 n 已经被上调至8的倍数
+// 假设 n 已经被上调至类别的区块大小
 template<int inst>
 void * __default_alloc_template<inst>::refill(size_t n) {
-    // 默认重新填充20个，可能应该内存紧张原因而不足
-    int nobjs = 20;
+    // 第一层默认重新填充20个，第二层按 slab 切分，可能应该内存紧张原因而不足
+    int nobjs = __pool_size_class::refill_count(n);
     // 调用chunk_alloc()向内存池中请求内存，其中 nobjs 传递引用，返回实际分配的个数
     char * chunk = chunk_alloc(n, nobjs);
     obj * volatile * my_free_list;
@@ -254,6 +1747,7 @@ void * __default_alloc_template<inst>::refill(size_t n) {
     obj * current_obj, * next_obj;
     int i;
     
+    ++counters.refills[FREELIST_INDEX(n)];
     // nobj == 1 直接返回给调用者
     if(1 == nobjs) return chunk;
     // 否则将其他节点纳入free list
@@ -282,7 +1776,7 @@ void * __default_alloc_template<inst>::refill(size_t n) {
 /**
  *  内存池
  *  从内存池中取出空间给 free list 是 chunk_alloc() 工作
- *  size已经是8的倍数，nbojs 通过引用传递，表示实际分配的空间数量
+ *  size已经是类别的区块大小，nbojs 通过引用传递，表示实际分配的空间数量
 */
 template<int inst>
 char * __default_alloc_template<inst>::chunk_alloc(size_t size, int & nbojs)
@@ -306,49 +1800,100 @@ char * __default_alloc_template<inst>::chunk_alloc(size_t size, int & nbojs)
     }else {
         // 内存池中空间连一块 size 大小空间都分配不出来
         // 需要向系统申请空间，申请大小一般为 2 * total_bytes + heap_size >> 4 大小
-        size_t bytes_to_get = 2 * total_bytes + ROUND_UP((heap_size >> 4));
+        size_t bytes_to_get = 2 * total_bytes + __pool_size_class::align_up((heap_size >> 4));
         // 先将内存池中剩余的碎片空间加入适当 free list 中
-        if(bytes_left > 0) {
+        // 碎片不一定恰好是某个类别的大小，依次切出不超过剩余空间的最大区块，剩余空间总是8的倍数
+        while(bytes_left >= __ALIGN) {
             // 寻找适当free list
-            obj * volatile * my_free_list = free_list + FREELIST_INDEX(bytes_left);
+            size_t index = __pool_size_class::floor_index(bytes_left);
+            obj * volatile * my_free_list = free_list + index;
             // 调整free list
             ((obj *)start_free)->free_list_link = *my_free_list;
             *my_free_list = (obj *)start_free;
+            start_free += __pool_size_class::size(index);
+            bytes_left -= __pool_size_class::size(index);
         }
 
+        // 剩余空间已经全部交给 free list，内存池暂时为空
+        start_free = end_free = 0;
+
         // 配置heap空间，补充内存池空间
-        start_free = (char *)malloc(bytes_to_get);
-        if(0 == start_free) {
+        // 每个 chunk 头部保存一个 chunk_header，用于登记 chunk 以便 trim() 整块归还
+        size_t chunk_bytes = bytes_to_get + sizeof(chunk_header);
+        char * chunk = (char *)chunk_source::allocate(chunk_bytes);
+        bool from_malloc_alloc = false;
+        ++counters.chunk_allocs;
+        if(0 == chunk) {
             // malloc() 申请空间失败
-            int i;
+            size_t i;
             obj * volatile * my_free_list, *p;
             // 检查 free list 有没有大的空间分配
-            for(i = size; i <= __MAX_BYTES; i += __ALIGN)
+            for(i = FREELIST_INDEX(size); i < __NFREELISTS; ++i)
             {
-                my_free_list = free_list + FREELIST_INDEX(i);
+                my_free_list = free_list + i;
                 p = *my_free_list;
                 if(0 != p) {
                     // free list 中由内存块未被利用
                     // 将free list 中的空间归还给内存池
                     *my_free_list = p->free_list_link;
+                    ++counters.freelist_reclaims;
                     start_free = (char *) p;
-                    end_free = start_free + i;
+                    end_free = start_free + __pool_size_class::size(i);
                     // 递归调用自己，调整nbojs分配空间
                     return (chunk_alloc(size, nbojs));
                 }
             }
             // free_list 中也没有内存可用，malloc() 也没有内存能分配
-            end_free = 0;
+            ++counters.malloc_fallbacks;
             // 调用第一级配置器，使用 out of memory 能不能分配出内存
-            start_free = (char *)malloc_alloc::allocate(bytes_to_get);
+            chunk_bytes = bytes_to_get + sizeof(chunk_header);
+            chunk = (char *)malloc_alloc::allocate(chunk_bytes);
+            from_malloc_alloc = true;
             // malloc_alloc 不能分配时会抛出异常
         }
+        // 登记新的 chunk，chunk 来源可能上调了大小
+        chunk_header * h = (chunk_header *)chunk;
+        h->size = chunk_bytes - sizeof(chunk_header);
+        h->from_malloc_alloc = from_malloc_alloc;
+        h->next = chunk_list;
+        chunk_list = h;
         // 更新内存池大小
-        heap_size += bytes_to_get;
-        end_free = start_free + bytes_to_get;
+        heap_size += h->size;
+        start_free = chunk + sizeof(chunk_header);
+        end_free = start_free + h->size;
         return (chunk_alloc(size, nbojs));
     }
 }
 
+// 从 mmap 大页区域配置 chunk 的内存池，可作为容器的 Alloc 参数，例如 map<Key, T, Compare, hugepage_alloc>
+typedef __default_alloc_template<__HUGEPAGE_POOL_INST> hugepage_alloc;
+
+/**
+ *  按 Align 对齐的配置器
+ *  Align 不超过 __ALIGN 时 Alloc 本身就能保证对齐，直接交给 Alloc；
+ *  否则交给第一级配置器的 allocate_aligned()，每个区块的起始地址都按 Align 对齐
+ *  例如 vector<float, __aligned_alloc_template<32> > 的缓冲区可以直接使用 AVX 的对齐读写，
+ *  list<T, __aligned_alloc_template<__CACHE_LINE> > 的每个节点独占缓存行的起始位置，不同线程使用的节点不会伪共享
+*/
+enum { __CACHE_LINE = 64 };
+
+template<size_t Align, class Alloc = __default_alloc_template<0> >
+class __aligned_alloc_template {
+    static_assert(Align != 0 && (Align & (Align - 1)) == 0, "Align must be a power of two");
+
+    // 两个版本在编译期选定
+    static void * allocate(size_t n, __true_type) { return Alloc::allocate(n); }
+    static void * allocate(size_t n, __false_type) { return malloc_alloc::allocate_aligned(n, Align); }
+    static void deallocate(void * p, size_t n, __true_type) { Alloc::deallocate(p, n); }
+    static void deallocate(void * p, size_t n, __false_type) { malloc_alloc::deallocate_aligned(p, n, Align); }
+
+    typedef typename __bool_type<(Align <= __ALIGN)>::type use_alloc;
+
+public:
+    enum { alignment = Align };
+
+    static void * allocate(size_t n) { return allocate(n, use_alloc()); }
+    static void deallocate(void * p, size_t n) { deallocate(p, n, use_alloc()); }
+};
 
 #endif
\ No newline at end of file
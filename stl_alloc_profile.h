@@ -0,0 +1,282 @@
+#ifndef __STL_ALLOC_PROFILE_H
+#define __STL_ALLOC_PROFILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <execinfo.h>
+#ifdef __STL_THREADS
+#include <mutex>
+#endif
+
+/**
+ *  抽样堆分析器
+ *  定义 __STL_ALLOC_PROFILE 后，simple_alloc 的每次配置与释放都会通知 __alloc_profiler，
+ *  平均每配置 __STL_ALLOC_PROFILE_RATE 个字节抽取一次样本，记录配置处的调用栈：
+ *      抽样间隔服从指数分布，大区块被抽中的概率与大小成正比，调用方无法与抽样周期同步；
+ *      每个调用栈(site)记录仍存活的以及累计的样本数量与字节数；
+ *      dump() 按 gperftools 的 heap profile 格式输出，可以直接交给 pprof 分析，pprof 会按抽样率还原真实的数值。
+ *  未被抽中的配置只有一次计数器递减，释放时只有在存在存活样本且地址命中过滤表时才加锁查找，
+ *  因此可以在线上常开。分析器自身的表直接使用 malloc/free，不经过任何配置器。
+ *  不经过 deallocate 就整体回收的空间(例如 monotonic_arena::release())中的样本会一直记为存活。
+*/
+#ifndef __STL_ALLOC_PROFILE_RATE
+#define __STL_ALLOC_PROFILE_RATE (512 * 1024)
+#endif
+
+template<int inst>
+class __alloc_profiler {
+private:
+    enum { __MAX_DEPTH = 32 };          // 记录的调用栈深度
+    enum { __NSITES = 4096 };           // 调用栈散列表的桶数
+    enum { __NSAMPLES = 4096 };         // 存活样本散列表的桶数
+    enum { __NFILTER = 1 << 16 };       // 释放时的地址过滤表
+
+    // 一个配置处(调用栈)的统计
+    struct site {
+        site * next;
+        size_t hash;
+        int depth;
+        void * stack[__MAX_DEPTH];
+        size_t live_count;
+        size_t live_bytes;
+        size_t total_count;
+        size_t total_bytes;
+    };
+
+    // 一个仍存活的样本
+    struct sample {
+        sample * next;
+        void * p;
+        size_t bytes;
+        site * owner;
+    };
+
+    static site * sites[__NSITES];
+    static sample * samples[__NSAMPLES];
+    // 每个地址槽中存活样本的数量，释放时不加锁先查这里
+    static std::atomic<unsigned> filter[__NFILTER];
+    static std::atomic<size_t> live_samples;
+    static size_t rate;
+#ifdef __STL_THREADS
+    static std::mutex lock;
+#endif
+
+    // 每个线程距离下一次抽样还需配置的字节数，以及产生抽样间隔的随机数状态
+    struct sampler {
+        long bytes_until_sample;
+        unsigned long long seed;
+        sampler() : bytes_until_sample(-1), seed(0) { }
+    };
+
+    static sampler & local_sampler() {
+#ifdef __STL_THREADS
+        static thread_local sampler s;
+#else
+        static sampler s;
+#endif
+        return s;
+    }
+
+    static size_t address_hash(const void * p) {
+        size_t x = (size_t)p;
+        return (x >> 4) ^ (x >> 20);
+    }
+
+    // 服从指数分布、均值为 rate 的抽样间隔
+    static long next_interval(sampler & s);
+
+    static void record(void * p, size_t bytes);
+    static void erase(void * p);
+
+    static void write_counts(FILE * out, size_t live_count, size_t live_bytes, size_t total_count, size_t total_bytes) {
+        fprintf(out, "%zu: %zu [%zu: %zu] @", live_count, live_bytes, total_count, total_bytes);
+    }
+
+public:
+    // 配置出 p 处 bytes 个字节之后调用
+    static void on_allocate(void * p, size_t bytes) {
+        if(0 == p) return;
+        sampler & s = local_sampler();
+        s.bytes_until_sample -= (long)bytes;
+        if(s.bytes_until_sample >= 0) return;
+        s.bytes_until_sample = next_interval(s);
+        record(p, bytes);
+    }
+
+    // 释放 p 之前调用
+    static void on_deallocate(void * p, size_t) {
+        if(0 == live_samples.load(std::memory_order_relaxed)) return;
+        if(0 == filter[address_hash(p) % __NFILTER].load(std::memory_order_relaxed)) return;
+        erase(p);
+    }
+
+    // 设置平均抽样间隔(字节)，只影响之后产生的间隔
+    static void set_rate(size_t bytes) { rate = bytes ? bytes : 1; }
+    static size_t get_rate() { return rate; }
+
+    // 按 heap profile 格式输出，写文件失败时返回 false
+    static void dump(FILE * out);
+    static bool dump(const char * path);
+};
+
+template<int inst>
+typename __alloc_profiler<inst>::site * __alloc_profiler<inst>::sites[__NSITES] = { 0 };
+
+template<int inst>
+typename __alloc_profiler<inst>::sample * __alloc_profiler<inst>::samples[__NSAMPLES] = { 0 };
+
+template<int inst>
+std::atomic<unsigned> __alloc_profiler<inst>::filter[__NFILTER];
+
+template<int inst>
+std::atomic<size_t> __alloc_profiler<inst>::live_samples(0);
+
+template<int inst>
+size_t __alloc_profiler<inst>::rate = __STL_ALLOC_PROFILE_RATE;
+
+#ifdef __STL_THREADS
+template<int inst>
+std::mutex __alloc_profiler<inst>::lock;
+#endif
+
+template<int inst>
+long __alloc_profiler<inst>::next_interval(sampler & s)
+{
+    if(0 == s.seed)
+        s.seed = ((unsigned long long)(size_t)&s << 16) ^ 0x9e3779b97f4a7c15ULL;
+    // xorshift64*，取高 53 位作为 (0, 1] 之间的均匀分布
+    s.seed ^= s.seed >> 12;
+    s.seed ^= s.seed << 25;
+    s.seed ^= s.seed >> 27;
+    unsigned long long r = (s.seed * 0x2545f4914f6cdd1dULL) >> 11;
+    double u = (r + 1.0) / 9007199254740992.0;
+    return (long)(-log(u) * (double)rate);
+}
+
+template<int inst>
+void __alloc_profiler<inst>::record(void * p, size_t bytes)
+{
+    // 取调用栈不需要加锁，跳过 record 自己
+    void * stack[__MAX_DEPTH + 1];
+    int depth = backtrace(stack, __MAX_DEPTH + 1) - 1;
+    if(depth < 0) depth = 0;
+    size_t h = 0;
+    for(int i = 0; i < depth; ++i)
+        h = (h ^ (size_t)stack[i + 1]) * 1099511628211ULL;
+
+    sample * smp = (sample *)malloc(sizeof(sample));
+    if(0 == smp) return;
+
+#ifdef __STL_THREADS
+    std::lock_guard<std::mutex> guard(lock);
+#endif
+    site * s = sites[h % __NSITES];
+    for(; 0 != s; s = s->next)
+        if(s->hash == h && s->depth == depth && 0 == memcmp(s->stack, stack + 1, depth * sizeof(void *)))
+            break;
+    if(0 == s) {
+        s = (site *)calloc(1, sizeof(site));
+        if(0 == s) { free(smp); return; }
+        s->hash = h;
+        s->depth = depth;
+        memcpy(s->stack, stack + 1, depth * sizeof(void *));
+        s->next = sites[h % __NSITES];
+        sites[h % __NSITES] = s;
+    }
+    ++s->live_count;
+    s->live_bytes += bytes;
+    ++s->total_count;
+    s->total_bytes += bytes;
+
+    size_t a = address_hash(p);
+    smp->p = p;
+    smp->bytes = bytes;
+    smp->owner = s;
+    smp->next = samples[a % __NSAMPLES];
+    samples[a % __NSAMPLES] = smp;
+    filter[a % __NFILTER].fetch_add(1, std::memory_order_relaxed);
+    live_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<int inst>
+void __alloc_profiler<inst>::erase(void * p)
+{
+    size_t a = address_hash(p);
+    sample * found = 0;
+    {
+#ifdef __STL_THREADS
+        std::lock_guard<std::mutex> guard(lock);
+#endif
+        for(sample ** cur = &samples[a % __NSAMPLES]; 0 != *cur; cur = &(*cur)->next) {
+            if((*cur)->p == p) {
+                found = *cur;
+                *cur = found->next;
+                break;
+            }
+        }
+        if(0 == found) return;
+        --found->owner->live_count;
+        found->owner->live_bytes -= found->bytes;
+        filter[a % __NFILTER].fetch_sub(1, std::memory_order_relaxed);
+        live_samples.fetch_sub(1, std::memory_order_relaxed);
+    }
+    free(found);
+}
+
+template<int inst>
+void __alloc_profiler<inst>::dump(FILE * out)
+{
+    {
+#ifdef __STL_THREADS
+        std::lock_guard<std::mutex> guard(lock);
+#endif
+        size_t live_count = 0, live_bytes = 0, total_count = 0, total_bytes = 0;
+        for(int i = 0; i < __NSITES; ++i) {
+            for(site * s = sites[i]; 0 != s; s = s->next) {
+                live_count += s->live_count;
+                live_bytes += s->live_bytes;
+                total_count += s->total_count;
+                total_bytes += s->total_bytes;
+            }
+        }
+        fprintf(out, "heap profile: ");
+        write_counts(out, live_count, live_bytes, total_count, total_bytes);
+        fprintf(out, " heap_v2/%zu\n", rate);
+
+        for(int i = 0; i < __NSITES; ++i) {
+            for(site * s = sites[i]; 0 != s; s = s->next) {
+                write_counts(out, s->live_count, s->live_bytes, s->total_count, s->total_bytes);
+                for(int k = 0; k < s->depth; ++k)
+                    fprintf(out, " %p", s->stack[k]);
+                fputc('\n', out);
+            }
+        }
+    }
+
+    // pprof 需要映射表才能把地址对应到二进制文件的符号
+    fprintf(out, "\nMAPPED_LIBRARIES:\n");
+    FILE * maps = fopen("/proc/self/maps", "r");
+    if(0 != maps) {
+        char buf[4096];
+        size_t n;
+        while((n = fread(buf, 1, sizeof(buf), maps)) > 0)
+            fwrite(buf, 1, n, out);
+        fclose(maps);
+    }
+}
+
+template<int inst>
+bool __alloc_profiler<inst>::dump(const char * path)
+{
+    FILE * out = fopen(path, "w");
+    if(0 == out) return false;
+    dump(out);
+    return 0 == fclose(out);
+}
+
+typedef __alloc_profiler<0> alloc_profiler;
+
+#endif
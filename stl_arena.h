@@ -0,0 +1,215 @@
+#ifndef __STL_ARENA_H
+#define __STL_ARENA_H
+
+#include <assert.h>
+#include "stl_alloc.h"
+
+/**
+ *  单调(monotonic)内存区
+ *  以指针递增的方式分配空间，deallocate 什么都不做，所有空间在 release() 或析构时一次性释放
+ *  适用于一次请求中创建、请求结束时一起丢弃的临时容器
+ *  空间以 block 为单位向 malloc_alloc 申请，block 大小按两倍增长
+ *  monotonic_arena 不是线程安全的，一个 arena 只能在一个线程中使用
+*/
+class monotonic_arena {
+private:
+    // 每个 block 头部的管理信息，大小为 __ALIGN 的倍数
+    struct block_header {
+        block_header * next;
+        size_t size;        // 包括 block_header 在内的字节数
+    };
+
+    enum { __ARENA_MAX_BLOCK = 1024 * 1024 };   // block 增长的上限
+
+    char * cur;             // 当前 block 中尚未分配的空间
+    char * end;
+    block_header * blocks;  // 向 malloc_alloc 申请的 block 链表
+    size_t next_block_size;
+    size_t used_bytes;      // 已经分配出去的字节数
+
+    monotonic_arena(const monotonic_arena &);
+    monotonic_arena & operator=(const monotonic_arena &);
+
+    static size_t round_up(size_t bytes) {
+        return (bytes + __ALIGN - 1) & ~((size_t)__ALIGN - 1);
+    }
+
+    // 向 malloc_alloc 申请一个 block，返回 block 中第一个可用地址
+    char * new_block(size_t block_size) {
+        block_header * h = (block_header *)malloc_alloc::allocate(block_size);
+        h->size = block_size;
+        h->next = blocks;
+        blocks = h;
+        return (char *)h + sizeof(block_header);
+    }
+
+    // 当前 block 不够时申请新的 block
+    void * allocate_slow(size_t n) {
+        used_bytes += n;
+        if(n > next_block_size / 4) {
+            // 较大的请求单独使用一个 block，当前 block 剩余的空间继续使用
+            return new_block(n + sizeof(block_header));
+        }
+        size_t block_size = next_block_size;
+        if(next_block_size < __ARENA_MAX_BLOCK)
+            next_block_size *= 2;
+        char * result = new_block(block_size);
+        cur = result + n;
+        end = result - sizeof(block_header) + block_size;
+        return result;
+    }
+
+public:
+    explicit monotonic_arena(size_t initial_size = 4096)
+        : cur(0), end(0), blocks(0), next_block_size(round_up(initial_size) + sizeof(block_header)), used_bytes(0) { }
+
+    // 先使用调用者提供的缓冲区(例如栈上的数组)，用完后再向 malloc_alloc 申请
+    monotonic_arena(void * buffer, size_t size)
+        : cur((char *)buffer), end((char *)buffer + size), blocks(0), next_block_size(2 * round_up(size) + sizeof(block_header)), used_bytes(0)
+    {
+        // 调用者的缓冲区起始地址不一定对齐
+        char * aligned = (char *)round_up((size_t)cur);
+        cur = aligned < end ? aligned : end;
+    }
+
+    ~monotonic_arena() { release(); }
+
+    void * allocate(size_t n) {
+        n = round_up(n);
+        if((size_t)(end - cur) < n)
+            return allocate_slow(n);
+        char * result = cur;
+        cur += n;
+        used_bytes += n;
+        return result;
+    }
+
+    void deallocate(void *, size_t) { }
+
+    // 一次切出 count 个大小为 n 的连续区块
+    void allocate_batch(size_t n, size_t count, void ** out) {
+        n = round_up(n);
+        char * p = (char *)allocate(n * count);
+        for(size_t i = 0; i < count; ++i, p += n)
+            out[i] = p;
+    }
+
+    void deallocate_batch(size_t, size_t, void **) { }
+
+    // 释放所有 block，之前分配出去的空间全部失效
+    void release() {
+        while(blocks != 0) {
+            block_header * next = blocks->next;
+            malloc_alloc::deallocate(blocks, blocks->size);
+            blocks = next;
+        }
+        cur = end = 0;
+        used_bytes = 0;
+    }
+
+    size_t bytes_allocated() const { return used_bytes; }
+};
+
+/**
+ *  scoped_arena 在作用域内把自己设为当前线程的当前 arena
+ *  离开作用域时恢复上一个 arena，并释放自己的全部空间
+*/
+class scoped_arena : public monotonic_arena {
+private:
+    monotonic_arena * prev;
+
+    static monotonic_arena *& current_arena() {
+        static thread_local monotonic_arena * arena = 0;
+        return arena;
+    }
+
+public:
+    explicit scoped_arena(size_t initial_size = 4096) : monotonic_arena(initial_size), prev(current_arena()) {
+        current_arena() = this;
+    }
+
+    scoped_arena(void * buffer, size_t size) : monotonic_arena(buffer, size), prev(current_arena()) {
+        current_arena() = this;
+    }
+
+    ~scoped_arena() { current_arena() = prev; }
+
+    // 当前线程的当前 arena，没有时返回 0
+    static monotonic_arena * current() { return current_arena(); }
+};
+
+/**
+ *  arena_alloc 只有静态接口，从当前线程的当前 scoped_arena 中分配空间
+ *  例如 vector<int, arena_alloc>，deallocate 为空操作，容器析构时不会真正释放空间
+ *  使用 arena_alloc 的容器必须在创建它的 scoped_arena 的作用域内构造、增长并析构
+*/
+class arena_alloc {
+public:
+    static void * allocate(size_t n) {
+        monotonic_arena * arena = scoped_arena::current();
+        assert(arena != 0 && "arena_alloc used outside of a scoped_arena");
+        return arena->allocate(n);
+    }
+
+    static void deallocate(void *, size_t) { }
+
+    static void allocate_batch(size_t n, size_t count, void ** out) {
+        monotonic_arena * arena = scoped_arena::current();
+        assert(arena != 0 && "arena_alloc used outside of a scoped_arena");
+        arena->allocate_batch(n, count, out);
+    }
+
+    static void deallocate_batch(size_t, size_t, void **) { }
+};
+
+/**
+ *  arena_allocator 是绑定某个 monotonic_arena 的有状态配置器，随容器保存
+ *  例如 vector<int, arena_allocator> v(arena_allocator(arena))，不同容器可以使用不同的 arena
+ *  默认构造时绑定当前线程的当前 scoped_arena，两个 arena_allocator 绑定同一个 arena 时相等
+*/
+class arena_allocator {
+private:
+    monotonic_arena * arena;
+
+public:
+    arena_allocator() : arena(scoped_arena::current()) { }
+    explicit arena_allocator(monotonic_arena & a) : arena(&a) { }
+
+    void * allocate(size_t n) {
+        assert(arena != 0 && "arena_allocator is not bound to an arena");
+        return arena->allocate(n);
+    }
+
+    void deallocate(void *, size_t) { }
+
+    void allocate_batch(size_t n, size_t count, void ** out) {
+        assert(arena != 0 && "arena_allocator is not bound to an arena");
+        arena->allocate_batch(n, count, out);
+    }
+
+    void deallocate_batch(size_t, size_t, void **) { }
+
+    monotonic_arena * resource() const { return arena; }
+
+    bool operator==(const arena_allocator & x) const { return arena == x.arena; }
+    bool operator!=(const arena_allocator & x) const { return arena != x.arena; }
+};
+
+template<>
+struct __alloc_traits<arena_alloc> {
+    typedef __false_type    propagate_on_copy_assignment;
+    typedef __true_type     propagate_on_move_assignment;
+    typedef __true_type     propagate_on_swap;
+    typedef __true_type     is_always_equal;
+    typedef __true_type     noop_deallocate;
+
+    static arena_alloc select_on_copy_construction(const arena_alloc& a) { return a; }
+    static bool equal(const arena_alloc&, const arena_alloc&) { return true; }
+};
+
+template<>
+struct __alloc_traits<arena_allocator> : public __stateful_alloc_traits<arena_allocator> {
+    typedef __true_type     noop_deallocate;
+};
+
+#endif
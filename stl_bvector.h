@@ -0,0 +1,566 @@
+#ifndef __STL_BVECTOR_H
+#define __STL_BVECTOR_H
+
+// vector.h 在末尾引入本文件；单独包含时先引入 vector.h，以取得
+// random_iterator_tag、simple_alloc 与主模板 vector
+#include "vector.h"
+#include <cstddef>
+#include <limits.h>
+#include <string.h>
+#include <assert.h>
+
+/**
+ *  vector<bool> 的特化版本，每个元素只占一个 bit，空间只有一般 vector<bool> 的 1/8
+ *  元素按 word(unsigned long)存放，第 i 个元素是第 i / __WORD_BIT 个 word 的第 i % __WORD_BIT 位
+ *  bit 不能直接取址，operator[] 与迭代器返回引用代理 __bit_reference
+ *  已配置空间中 size() 之后的 bit 始终为 0，因此 count()、find_first()、find_next()
+ *  以及 &=、|=、^= 可以整个 word 一起处理，不需要单独处理最后一个 word
+ *  本文件可以单独包含，也由 vector.h 在末尾引入
+*/
+typedef unsigned long __bit_word;
+enum { __WORD_BIT = int(CHAR_BIT * sizeof(__bit_word)) };
+
+// word 中为 1 的 bit 个数
+inline size_t __bit_popcount(__bit_word x) {
+#ifdef __GNUC__
+    return __builtin_popcountl(x);
+#else
+    size_t n = 0;
+    for(; x; x &= x - 1) ++n;
+    return n;
+#endif
+}
+
+// word 中最低的 1 所在的位置，x 不能为 0
+inline size_t __bit_ctz(__bit_word x) {
+#ifdef __GNUC__
+    return __builtin_ctzl(x);
+#else
+    size_t n = 0;
+    for(; !(x & 1); x >>= 1) ++n;
+    return n;
+#endif
+}
+
+// bit 的引用代理，记录所在的 word 以及该 bit 的掩码
+struct __bit_reference {
+    __bit_word * p;
+    __bit_word mask;
+    __bit_reference(__bit_word * x, __bit_word y) : p(x), mask(y) { }
+
+    __bit_reference() : p(0), mask(0) { }
+    operator bool() const { return !(!(*p & mask)); }
+    __bit_reference& operator=(bool x) {
+        if(x) *p |= mask;
+        else  *p &= ~mask;
+        return *this;
+    }
+    __bit_reference& operator=(const __bit_reference& x) { return *this = bool(x); }
+    bool operator==(const __bit_reference& x) const { return bool(*this) == bool(x); }
+    bool operator<(const __bit_reference& x) const { return !bool(*this) && bool(x); }
+    void flip() { *p ^= mask; }
+};
+
+inline void swap(__bit_reference x, __bit_reference y) {
+    bool tmp = x;
+    x = y;
+    y = tmp;
+}
+
+// bit 迭代器的公共部分：所在的 word 以及 word 中的位置
+struct __bit_iterator_base {
+    __bit_word * p;
+    unsigned int offset;
+
+    __bit_iterator_base(__bit_word * x, unsigned int y) : p(x), offset(y) { }
+
+    void bump_up() {
+        if(offset++ == __WORD_BIT - 1) {
+            offset = 0;
+            ++p;
+        }
+    }
+    void bump_down() {
+        if(offset-- == 0) {
+            offset = __WORD_BIT - 1;
+            --p;
+        }
+    }
+    void incr(ptrdiff_t i) {
+        ptrdiff_t n = i + offset;
+        p += n / __WORD_BIT;
+        n = n % __WORD_BIT;
+        if(n < 0) {
+            offset = (unsigned int)(n + __WORD_BIT);
+            --p;
+        } else {
+            offset = (unsigned int)n;
+        }
+    }
+
+    bool operator==(const __bit_iterator_base& i) const { return p == i.p && offset == i.offset; }
+    bool operator!=(const __bit_iterator_base& i) const { return p != i.p || offset != i.offset; }
+    bool operator<(const __bit_iterator_base& i) const { return p < i.p || (p == i.p && offset < i.offset); }
+    bool operator>(const __bit_iterator_base& i) const { return i < *this; }
+    bool operator<=(const __bit_iterator_base& i) const { return !(i < *this); }
+    bool operator>=(const __bit_iterator_base& i) const { return !(*this < i); }
+};
+
+inline ptrdiff_t operator-(const __bit_iterator_base& x, const __bit_iterator_base& y) {
+    return __WORD_BIT * (x.p - y.p) + (ptrdiff_t)x.offset - (ptrdiff_t)y.offset;
+}
+
+struct __bit_iterator : public __bit_iterator_base {
+    typedef random_iterator_tag     iterator_category;
+    typedef bool                    value_type;
+    typedef ptrdiff_t               difference_type;
+    typedef __bit_reference         reference;
+    typedef __bit_reference*        pointer;
+    typedef __bit_iterator          iterator;
+
+    __bit_iterator() : __bit_iterator_base(0, 0) { }
+    __bit_iterator(__bit_word * x, unsigned int y) : __bit_iterator_base(x, y) { }
+
+    reference operator*() const { return reference(p, 1UL << offset); }
+    iterator& operator++() { bump_up(); return *this; }
+    iterator operator++(int) { iterator tmp = *this; bump_up(); return tmp; }
+    iterator& operator--() { bump_down(); return *this; }
+    iterator operator--(int) { iterator tmp = *this; bump_down(); return tmp; }
+    iterator& operator+=(difference_type i) { incr(i); return *this; }
+    iterator& operator-=(difference_type i) { incr(-i); return *this; }
+    iterator operator+(difference_type i) const { iterator tmp = *this; return tmp += i; }
+    iterator operator-(difference_type i) const { iterator tmp = *this; return tmp -= i; }
+    reference operator[](difference_type i) const { return *(*this + i); }
+};
+
+struct __bit_const_iterator : public __bit_iterator_base {
+    typedef random_iterator_tag     iterator_category;
+    typedef bool                    value_type;
+    typedef ptrdiff_t               difference_type;
+    typedef bool                    reference;
+    typedef bool                    const_reference;
+    typedef const bool*             pointer;
+    typedef __bit_const_iterator    const_iterator;
+
+    __bit_const_iterator() : __bit_iterator_base(0, 0) { }
+    __bit_const_iterator(__bit_word * x, unsigned int y) : __bit_iterator_base(x, y) { }
+    __bit_const_iterator(const __bit_iterator& x) : __bit_iterator_base(x.p, x.offset) { }
+
+    const_reference operator*() const { return __bit_reference(p, 1UL << offset); }
+    const_iterator& operator++() { bump_up(); return *this; }
+    const_iterator operator++(int) { const_iterator tmp = *this; bump_up(); return tmp; }
+    const_iterator& operator--() { bump_down(); return *this; }
+    const_iterator operator--(int) { const_iterator tmp = *this; bump_down(); return tmp; }
+    const_iterator& operator+=(difference_type i) { incr(i); return *this; }
+    const_iterator& operator-=(difference_type i) { incr(-i); return *this; }
+    const_iterator operator+(difference_type i) const { const_iterator tmp = *this; return tmp += i; }
+    const_iterator operator-(difference_type i) const { const_iterator tmp = *this; return tmp -= i; }
+    const_reference operator[](difference_type i) const { return *(*this + i); }
+};
+
+template <class Alloc, class Growth>
+class vector<bool, Alloc, Growth> : protected simple_alloc<__bit_word, Alloc> {
+public:
+    using value_type = bool;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = __bit_reference;
+    using const_reference = bool;
+    using iterator = __bit_iterator;
+    using const_iterator = __bit_const_iterator;
+    using word_type = __bit_word;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+
+protected:
+    // 以 word 为单位配置空间
+    using data_allocator    =   simple_alloc<__bit_word, Alloc>;
+    using alloc_traits      =   __alloc_traits<Alloc>;
+    iterator start;             // 第一个 bit
+    iterator finish;            // 最后一个 bit 的下一个位置
+    __bit_word * end_of_storage;  // 已配置的最后一个 word 的下一个位置
+
+    // 容纳 n 个 bit 需要的 word 数
+    static size_type words_for(size_type n) { return (n + __WORD_BIT - 1) / __WORD_BIT; }
+    // 存有元素的 word 数
+    size_type used_words() const { return size_type(finish.p - start.p) + (finish.offset != 0); }
+    // 已配置的 word 数
+    size_type storage_words() const { return size_type(end_of_storage - start.p); }
+
+    // 还需要放入 n 个 bit 时的新容量(word 数)
+    size_type next_words(size_type n) const {
+        return fit_words(words_for(Growth::grow(size(), n)), typename Growth::fit_allocator());
+    }
+    size_type fit_words(size_type len, __false_type) const { return len; }
+    size_type fit_words(size_type len, __true_type) const { return data_allocator::good_size(len); }
+
+    // 将容量调整为 n 个 word，word 按位搬移，新增的 word 清零
+    void reallocate_storage(size_type n) {
+        const size_type old_size = size();
+        const size_type old_words = storage_words();
+        __bit_word * p = data_allocator::reallocate(start.p, old_words, n);
+        if(n > old_words)
+            memset(p + old_words, 0, (n - old_words) * sizeof(__bit_word));
+        start = iterator(p, 0);
+        finish = start + old_size;
+        end_of_storage = p + n;
+    }
+
+    // 保证还能再放入 n 个 bit，不够时按增长策略扩充容量
+    void reserve_more(size_type n) {
+        if(capacity() - size() < n)
+            reallocate_storage(next_words(n));
+    }
+
+    // 配置能容纳 n 个 bit 的空间并全部清零，元素个数为 n
+    void initialize(size_type n) {
+        const size_type len = words_for(n);
+        __bit_word * p = data_allocator::allocate(len);
+        if(len)
+            memset(p, 0, len * sizeof(__bit_word));
+        start = iterator(p, 0);
+        finish = start + n;
+        end_of_storage = p + len;
+    }
+
+    void deallocate() {
+        if(start.p)
+            data_allocator::deallocate(start.p, storage_words());
+    }
+
+    void release() {
+        deallocate();
+        start = finish = iterator();
+        end_of_storage = 0;
+    }
+
+    void steal(vector& x) {
+        start = x.start;
+        finish = x.finish;
+        end_of_storage = x.end_of_storage;
+        x.start = x.finish = iterator();
+        x.end_of_storage = 0;
+    }
+
+    // 将 [first, last) 的 bit 全部置为 x，中间的整个 word 直接赋值
+    static void fill_bits(iterator first, iterator last, bool x);
+
+    // 复制 x 的全部 bit，不改变配置器
+    void assign_elements(const vector& x);
+
+    template <class Integer>
+    void initialize_dispatch(Integer n, Integer x, __true_type) {
+        initialize((size_type)n);
+        fill_bits(start, finish, (bool)x);
+    }
+    template <class InputIterator>
+    void initialize_dispatch(InputIterator first, InputIterator last, __false_type) {
+        start = finish = iterator();
+        end_of_storage = 0;
+        try {
+            insert(end(), first, last);
+        } catch(...) {
+            release();
+            throw;
+        }
+    }
+
+    template <class Integer>
+    void insert_dispatch(iterator position, Integer n, Integer x, __true_type) { insert(position, (size_type)n, (bool)x); }
+    template <class InputIterator>
+    void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+    { range_insert(position, first, last, iterator_category(first)); }
+
+    template <class InputIterator>
+    void range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag) {
+        for(; first != last; ++first, ++position)
+            position = insert(position, *first);
+    }
+    template <class ForwardIterator>
+    void range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+        const size_type n = ::distance(first, last);
+        if(0 == n) return;
+        const difference_type index = position - begin();
+        reserve_more(n);
+        position = begin() + index;
+        MYSTL::copy_backward(position, finish, finish + n);
+        MYSTL::copy(first, last, position);
+        finish += n;
+    }
+
+public:
+    iterator begin() { return start; }
+    iterator end()   { return finish; }
+    const_iterator begin() const { return start; }
+    const_iterator end() const { return finish; }
+
+    size_type size() const { return size_type(finish - start); }
+    size_type capacity() const { return storage_words() * __WORD_BIT; }
+    bool empty() const { return start == finish; }
+
+    reference operator[](size_type n) { return *(begin() + difference_type(n)); }
+    const_reference operator[](size_type n) const { return *(begin() + difference_type(n)); }
+
+    reference front() { return *begin(); }
+    const_reference front() const { return *begin(); }
+    reference back() { return *(end() - 1); }
+    const_reference back() const { return *(end() - 1); }
+
+    vector() : end_of_storage(0) { }
+    explicit vector(const Alloc& a) : data_allocator(a), end_of_storage(0) { }
+    vector(size_type n, bool value, const Alloc& a = Alloc()) : data_allocator(a) {
+        initialize(n);
+        fill_bits(start, finish, value);
+    }
+    explicit vector(size_type n, const Alloc& a = Alloc()) : data_allocator(a) { initialize(n); }
+
+    // 两个参数是同一种整数类型时表示 n 个 x
+    template <class InputIterator>
+    vector(InputIterator first, InputIterator last, const Alloc& a = Alloc()) : data_allocator(a) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        initialize_dispatch(first, last, is_integer());
+    }
+
+    vector(const vector& x) : data_allocator(alloc_traits::select_on_copy_construction(x.allocator())) {
+        initialize(x.size());
+        if(x.used_words())
+            memcpy(start.p, x.start.p, x.used_words() * sizeof(__bit_word));
+    }
+
+    vector(const vector& x, const Alloc& a) : data_allocator(a) {
+        initialize(x.size());
+        if(x.used_words())
+            memcpy(start.p, x.start.p, x.used_words() * sizeof(__bit_word));
+    }
+
+    vector(vector&& x) : data_allocator(x.allocator()) { steal(x); }
+
+    ~vector() { deallocate(); }
+
+    vector& operator=(const vector& x) {
+        if(this != &x) {
+            if(__alloc_copy_changes(this->allocator(), x.allocator()))
+                release();
+            __alloc_copy_assign(this->allocator(), x.allocator());
+            assign_elements(x);
+        }
+        return *this;
+    }
+
+    vector& operator=(vector&& x) {
+        if(this != &x) {
+            if(__alloc_move_steals(this->allocator(), x.allocator())) {
+                release();
+                __alloc_move_assign(this->allocator(), x.allocator());
+                steal(x);
+            } else {
+                assign_elements(x);
+            }
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return this->allocator(); }
+
+    void push_back(bool x) {
+        if(finish.p == end_of_storage)
+            reallocate_storage(next_words(1));
+        if(x)
+            *finish = true;
+        ++finish;
+    }
+
+    void pop_back() {
+        --finish;
+        *finish = false;
+    }
+
+    iterator insert(iterator position, bool x) {
+        const difference_type index = position - begin();
+        reserve_more(1);
+        position = begin() + index;
+        MYSTL::copy_backward(position, finish, finish + 1);
+        *position = x;
+        ++finish;
+        return position;
+    }
+
+    void insert(iterator position, size_type n, bool x) {
+        if(0 == n) return;
+        const difference_type index = position - begin();
+        reserve_more(n);
+        position = begin() + index;
+        MYSTL::copy_backward(position, finish, finish + n);
+        fill_bits(position, position + n, x);
+        finish += n;
+    }
+
+    template <class InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        insert_dispatch(position, first, last, is_integer());
+    }
+
+    template <class InputIterator>
+    void append_range(InputIterator first, InputIterator last) { insert(end(), first, last); }
+    template <class Range>
+    void append_range(const Range& r) { insert(end(), r.begin(), r.end()); }
+
+    iterator erase(iterator position) {
+        if(position + 1 != end())
+            MYSTL::copy(position + 1, finish, position);
+        pop_back();
+        return position;
+    }
+
+    iterator erase(iterator first, iterator last) {
+        iterator i = MYSTL::copy(last, finish, first);
+        fill_bits(i, finish, false);
+        finish = i;
+        return first;
+    }
+
+    void resize(size_type new_size, bool x = false) {
+        if(new_size < size())
+            erase(begin() + difference_type(new_size), end());
+        else
+            insert(end(), new_size - size(), x);
+    }
+
+    void reserve(size_type n) {
+        if(capacity() < n)
+            reallocate_storage(words_for(n));
+    }
+
+    void shrink_to_fit() {
+        if(storage_words() != words_for(size()))
+            reallocate_storage(words_for(size()));
+    }
+
+    void clear() { erase(begin(), end()); }
+
+    void assign(size_type n, bool x) {
+        clear();
+        insert(end(), n, x);
+    }
+    template <class InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        clear();
+        insert(end(), first, last);
+    }
+
+    void swap(vector& x) {
+        __alloc_swap(this->allocator(), x.allocator());
+        MYSTL::swap(start, x.start);
+        MYSTL::swap(finish, x.finish);
+        MYSTL::swap(end_of_storage, x.end_of_storage);
+    }
+
+    static void swap(reference x, reference y) { ::swap(x, y); }
+
+    /**
+     *  以下操作一次处理一个 word
+     *  count() 返回为 1 的元素个数
+     *  find_first() 返回第一个为 1 的元素的下标，find_next(pos) 返回 pos 之后第一个为 1 的元素的下标，
+     *  没有时都返回 size()
+     *  flip() 将全部元素取反，&=、|=、^= 要求两个 vector 的 size() 相同
+    */
+    size_type count() const {
+        size_type n = 0;
+        for(size_type i = 0, len = used_words(); i < len; ++i)
+            n += __bit_popcount(start.p[i]);
+        return n;
+    }
+
+    size_type find_first() const { return find_from(0); }
+
+    size_type find_next(size_type pos) const {
+        if(++pos >= size()) return size();
+        size_type i = pos / __WORD_BIT;
+        __bit_word w = start.p[i] & (~0UL << (pos % __WORD_BIT));
+        if(w)
+            return i * __WORD_BIT + __bit_ctz(w);
+        return find_from(i + 1);
+    }
+
+    void flip() {
+        for(size_type i = 0, len = used_words(); i < len; ++i)
+            start.p[i] = ~start.p[i];
+        // 最后一个 word 中 size() 之后的 bit 恢复为 0
+        if(finish.offset)
+            *finish.p &= ~0UL >> (__WORD_BIT - finish.offset);
+    }
+
+    vector& operator&=(const vector& x) {
+        assert(size() == x.size());
+        for(size_type i = 0, len = used_words(); i < len; ++i)
+            start.p[i] &= x.start.p[i];
+        return *this;
+    }
+
+    vector& operator|=(const vector& x) {
+        assert(size() == x.size());
+        for(size_type i = 0, len = used_words(); i < len; ++i)
+            start.p[i] |= x.start.p[i];
+        return *this;
+    }
+
+    vector& operator^=(const vector& x) {
+        assert(size() == x.size());
+        for(size_type i = 0, len = used_words(); i < len; ++i)
+            start.p[i] ^= x.start.p[i];
+        return *this;
+    }
+
+private:
+    // 从第 i 个 word 开始查找第一个为 1 的 bit
+    size_type find_from(size_type i) const {
+        for(size_type len = used_words(); i < len; ++i)
+            if(start.p[i])
+                return i * __WORD_BIT + __bit_ctz(start.p[i]);
+        return size();
+    }
+};
+
+template <class Alloc, class Growth>
+void vector<bool, Alloc, Growth>::fill_bits(iterator first, iterator last, bool x) {
+    if(!(first < last)) return;
+    const __bit_word all = ~0UL;
+    if(first.p == last.p) {
+        __bit_word mask = (all >> (__WORD_BIT - (last.offset - first.offset))) << first.offset;
+        if(x) *first.p |= mask;
+        else  *first.p &= ~mask;
+        return;
+    }
+    if(first.offset) {
+        __bit_word mask = all << first.offset;
+        if(x) *first.p |= mask;
+        else  *first.p &= ~mask;
+        ++first.p;
+    }
+    if(last.p != first.p)
+        memset(first.p, x ? 0xff : 0, (last.p - first.p) * sizeof(__bit_word));
+    if(last.offset) {
+        __bit_word mask = all >> (__WORD_BIT - last.offset);
+        if(x) *last.p |= mask;
+        else  *last.p &= ~mask;
+    }
+}
+
+template <class Alloc, class Growth>
+void vector<bool, Alloc, Growth>::assign_elements(const vector& x) {
+    const size_type len = x.size();
+    if(len > capacity()) {
+        release();
+        initialize(len);
+    } else {
+        // 多出来的 bit 清零，x 最后一个 word 中 size() 之后的 bit 本来就是 0
+        if(len < size())
+            fill_bits(start + difference_type(len), finish, false);
+        finish = start + difference_type(len);
+    }
+    if(x.used_words())
+        memcpy(start.p, x.start.p, x.used_words() * sizeof(__bit_word));
+}
+
+#endif
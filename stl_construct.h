@@ -6,6 +6,7 @@
  *  对特化版本使用高效的construct()/destroy()。
 */
 #include <new>
+#include <utility>
 #include "type_traits.h"
 #include "stl_iterator.h"
 #include <iostream>
@@ -17,6 +18,13 @@ inline void construct(T1* p, const T2& value)
     new (p) T1(value);
 }
 
+// 以 args 为参数在 p 地址上直接构造 T1，右值参数会被完美转发
+template<typename T1, typename... Args>
+inline void construct(T1* p, Args&&... args)
+{
+    new (p) T1(std::forward<Args>(args)...);
+}
+
 template<typename T>
 inline void destroy(T* pointer)
 {
@@ -24,20 +32,16 @@ inline void destroy(T* pointer)
 }
 
 
-template<class ForwardIterator, class T>
-inline void __destroy(ForwardIterator first, ForwardIterator last, T)
-{
-    typedef typename __type_traits<T>::has_trivial_destructor trivial_destructor;
-    __destroy_aux(first, last, trivial_destructor());
-}
-
 /**
  *  接受两个迭代器并对特定类型进行优化dstr()
+ *  元素类型通过 iterator_traits 取得，不要求元素可以默认构造
 */
 template<class ForwardIterator>
 inline void destroy(ForwardIterator first, ForwardIterator last)
 {
-    __destroy( (ForwardIterator)first, (ForwardIterator)last, value_type(first) );
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename __type_traits<T>::has_trivial_destructor trivial_destructor;
+    __destroy_aux(first, last, trivial_destructor());
 }
 
 //value type 如果有 non-trivial destructor
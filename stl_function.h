@@ -14,4 +14,29 @@ struct identity {
     }
 };
 
+/**
+ *  与固定值 value 比较的一元谓词：x == value、x != value、x < value、x > value
+ *  例如 find_if(first, last, greater_than_value<int>(0)) 找出第一个正数；
+ *  区间为原生指针、元素为整数时 find_if()/count_if() 能识别这几种谓词，改用向量化的比较(见 stl_simd.h)
+*/
+enum __compare_op { __cmp_eq, __cmp_ne, __cmp_lt, __cmp_gt };
+
+template<typename T, int Op>
+struct __compare_to_value {
+    T value;
+
+    explicit __compare_to_value(const T& v) : value(v) { }
+
+    bool operator()(const T& x) const {
+        return __cmp_eq == Op ? x == value :
+               __cmp_ne == Op ? x != value :
+               __cmp_lt == Op ? x < value : value < x;
+    }
+};
+
+template<typename T> using equal_to_value     = __compare_to_value<T, __cmp_eq>;
+template<typename T> using not_equal_to_value = __compare_to_value<T, __cmp_ne>;
+template<typename T> using less_than_value    = __compare_to_value<T, __cmp_lt>;
+template<typename T> using greater_than_value = __compare_to_value<T, __cmp_gt>;
+
 #endif
@@ -6,6 +6,7 @@
 #include "vector.h"
 #include "algo.h"
 #include "stl_pair.h"
+#include <utility>
 
 //实践表明，如果hash表的大小为质数，hash碰撞的概率会极大地减少
 static const int __stl_num_primes = 28;
@@ -39,7 +40,7 @@ class hashtable;
 
 template<class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
 struct __hashtable_iterator{
-    typedef hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> hashtable;
+    typedef hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> self_table;
     typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> iterator;
     typedef __hashtable_node<Value> node;
 
@@ -51,9 +52,9 @@ struct __hashtable_iterator{
     typedef Value* pointer;
 
     node* cur;      //迭代器目前保存的指针
-    hashtable* ht;  //建立迭代器与hashtable的联系
+    self_table* ht;  //建立迭代器与hashtable的联系
 
-    __hashtable_iterator(node* n, hashtable* tab) : cur(n), ht(tab) {}
+    __hashtable_iterator(node* n, self_table* tab) : cur(n), ht(tab) {}
     __hashtable_iterator() {}
 
     reference operator*() { return (cur->val); }
@@ -90,8 +91,12 @@ __hashtable_iterator<Value, Key, HashFcn, ExtrackKey, EqualKey, Alloc>::operator
 }
 
 
+/**
+ *  hashtable 继承自己的节点配置器，从而持有一个 Alloc 对象，buckets 也使用同一个 Alloc 对象
+ *  复制、移动、交换时按照 __alloc_traits<Alloc> 的规则处理配置器
+*/
 template<class Value, class Key, class HashFcn, class ExtracKey,  class EqualKey, class Alloc=__default_alloc_template<0>>
-class hashtable{
+class hashtable : protected simple_alloc<__hashtable_node<Value>, Alloc> {
 public:
     typedef HashFcn hasher;
     typedef EqualKey key_equal;
@@ -104,6 +109,7 @@ public:
     typedef const value_type*   const_pointer;
     typedef value_type& reference;
     typedef const value_type& const_reference;
+    typedef Alloc   allocator_type;
 
 // 迭代器
 public:
@@ -118,6 +124,9 @@ private:
 
     typedef __hashtable_node<Value> node;
     typedef simple_alloc<node, Alloc> node_allocator;
+    typedef __alloc_traits<Alloc> alloc_traits;
+    typedef __node_batch<node, Alloc> node_batch;
+    typedef __node_release<node, Alloc> node_release;
 
     vector<node*, Alloc> buckets;
     size_type num_elements;
@@ -132,12 +141,32 @@ private:
         return n;
     }
 
+    // 从 batch 中取出节点并构造，batch 为 0 时单独配置
+    node* new_node(node_batch* batch, const value_type& obj)
+    {
+        if(batch == 0)
+            return new_node(obj);
+        node *n = batch->get();
+        n->next = 0;
+        try {
+            construct(&n->val, obj);
+        } catch(...) {
+            batch->put(n);
+            throw;
+        }
+        return n;
+    }
+
     void delete_node(node *n)
     {
         destroy(&n->val);
         node_allocator::deallocate(n);
     }
 
+    // 析构并归还全部节点，不修改 buckets
+    void release_nodes(__true_type) { }     // 节点空间由配置器整体回收，不需要遍历
+    void release_nodes(__false_type);
+
 private:
     // 初始化哈希表的buckets
     void initialized_buckets(size_type n)
@@ -153,14 +182,18 @@ private:
 
 protected:
     // 插入元素，不允许重复
-    pair<iterator, bool> insert_unique_noresize(const value_type& obj);
+    pair<iterator, bool> insert_unique_noresize(const value_type& obj, node_batch* batch = 0);
     // 插入元素，允许重复
-    iterator insert_equal_noresize(const value_type& obj);
+    iterator insert_equal_noresize(const value_type& obj, node_batch* batch = 0);
 
-    // hash出元素在buckets中的位置
-    size_type bkt_num_key(const value_type& obj, size_t n) const
+    // hash出键值在buckets中的位置
+    size_type bkt_num_key(const key_type& key, size_t n) const
+    {
+        return hash(key) % n;
+    }
+    size_type bkt_num_key(const key_type& key) const
     {
-        return hash(obj) % n;
+        return bkt_num_key(key, buckets.size());
     }
 public:
     size_type bucket_count() const { return buckets.size(); }
@@ -172,12 +205,76 @@ public:
 public:
     // construct
     // 传入初始化哈希表大小，哈希函数，Key值比较函数
-    hashtable(size_type n, const HashFcn& hf, const EqualKey& eql) : hash(hf), equals(eql), get_key(ExtracKey()), num_elements(0) 
+    hashtable(size_type n, const HashFcn& hf, const EqualKey& eql, const Alloc& a = Alloc())
+        : node_allocator(a), hash(hf), equals(eql), get_key(ExtracKey()), buckets(a), num_elements(0) 
     {
         // 初始化bucket大小
         initialized_buckets(n);
     }
 
+    hashtable(const hashtable& ht)
+        : node_allocator(alloc_traits::select_on_copy_construction(ht.allocator())),
+          hash(ht.hash), equals(ht.equals), get_key(ht.get_key), buckets(this->allocator()), num_elements(0)
+    {
+        copy_from(ht);
+    }
+
+    // 移动构造，接管 ht 的 buckets，ht 成为没有 bucket 的空表，不配置任何空间
+    hashtable(hashtable&& ht) noexcept
+        : node_allocator(ht.allocator()), hash(ht.hash), equals(ht.equals), get_key(ht.get_key),
+          buckets(std::move(ht.buckets)), num_elements(ht.num_elements)
+    {
+        ht.num_elements = 0;
+    }
+
+    // 析构时 buckets 随之释放，不需要再置空
+    ~hashtable() {
+        if(0 != num_elements)
+            release_nodes(typename __node_teardown<Value, Alloc>::skip());
+    }
+
+    hashtable& operator=(const hashtable& ht) {
+        if(this != &ht) {
+            // 先用原来的配置器释放所有节点，再按规则复制配置器
+            clear();
+            __alloc_copy_assign(this->allocator(), ht.allocator());
+            hash = ht.hash;
+            equals = ht.equals;
+            get_key = ht.get_key;
+            copy_from(ht);
+        }
+        return *this;
+    }
+
+    hashtable& operator=(hashtable&& ht) {
+        if(this != &ht) {
+            clear();
+            hash = ht.hash;
+            equals = ht.equals;
+            get_key = ht.get_key;
+            if(__alloc_move_steals(this->allocator(), ht.allocator())) {
+                __alloc_move_assign(this->allocator(), ht.allocator());
+                buckets = std::move(ht.buckets);
+                num_elements = ht.num_elements;
+                ht.num_elements = 0;
+            } else {
+                copy_from(ht);
+            }
+        }
+        return *this;
+    }
+
+    void swap(hashtable& ht) {
+        __alloc_swap(this->allocator(), ht.allocator());
+        buckets.swap(ht.buckets);
+        std::swap(hash, ht.hash);
+        std::swap(equals, ht.equals);
+        std::swap(get_key, ht.get_key);
+        std::swap(num_elements, ht.num_elements);
+    }
+
+    allocator_type get_allocator() const { return this->allocator(); }
+
     // 插入元素，不允许重复
     pair<iterator, bool> insert_unique(const value_type& obj){
         resize(num_elements + 1);
@@ -189,6 +286,30 @@ public:
         return insert_equal_noresize(obj);
     }
 
+    // 区间插入，不允许重复，节点成批配置
+    template<class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last){
+        size_type n = __batch_hint(first, last);
+        resize(num_elements + n);
+        node_batch batch(*this, n);
+        for(; first != last; ++first) {
+            if(n == 0) resize(num_elements + 1);    // 区间长度未知时逐个检查
+            insert_unique_noresize(*first, &batch);
+        }
+    }
+
+    // 区间插入，允许重复，节点成批配置
+    template<class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last){
+        size_type n = __batch_hint(first, last);
+        resize(num_elements + n);
+        node_batch batch(*this, n);
+        for(; first != last; ++first) {
+            if(n == 0) resize(num_elements + 1);
+            insert_equal_noresize(*first, &batch);
+        }
+    }
+
     /**
      *  Hash出元素在buckets中的位置
     */
@@ -235,20 +356,31 @@ public:
 };
 
 template<class V, class K, class HF, class Ex, class Eq, class A>
-void hashtable<V, K, HF, Ex, Eq, A>::clear()
+void hashtable<V, K, HF, Ex, Eq, A>::release_nodes(__false_type)
 {
+    node_release released(*this);
     // 对一个bucket
     for(size_type i = 0; i < buckets.size(); ++i)
     {
         node *first = buckets[i];
         while(first != 0)
         {
-            buckets[i] = first->next;
-            delete_node(first);
-            first = buckets[i];
+            node *next = first->next;
+            destroy(&first->val);
+            released.put(first);
+            first = next;
         }
-        buckets[i] = 0;
     }
+}
+
+template<class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::clear()
+{
+    if(0 != num_elements)
+        release_nodes(typename __node_teardown<V, A>::skip());
+    // bucket 数组保留，全部置空
+    for(size_type i = 0; i < buckets.size(); ++i)
+        buckets[i] = 0;
     num_elements = 0;
 }
 
@@ -261,7 +393,7 @@ void hashtable<V, K, HF, Ex, Eq, A>::clear()
     if(num_element_hint > old_size){
         const size_type n = next_size(num_element_hint);    // 找出下一个质数
         if(n > old_size){   // 防止buckets已经到最大内存分配后，没有增长后又重新分配
-            vector<node*, A> tmp(n, (node *)0);
+            vector<node*, A> tmp(n, (node *)0, this->allocator());
             // 递归处理原来buckets中的node *
             for(size_type bucket = 0; bucket < buckets.size(); ++bucket) {
                 node *first = buckets[bucket];
@@ -282,7 +414,7 @@ void hashtable<V, K, HF, Ex, Eq, A>::clear()
 // 插入元素，允许重复
 template<class V, class K, class HF, class Ex, class Eq, class A>
 pair<typename hashtable<V, K, HF, Ex, Eq, A>::iterator, bool> 
-hashtable<V, K, HF, Ex, Eq, A>::insert_unique_noresize(const value_type& obj)
+hashtable<V, K, HF, Ex, Eq, A>::insert_unique_noresize(const value_type& obj, node_batch* batch)
 {
     // Hash得到num bucket
     const size_type n = bkt_num(obj);
@@ -296,17 +428,17 @@ hashtable<V, K, HF, Ex, Eq, A>::insert_unique_noresize(const value_type& obj)
     }
 
     // 离开循环或者没有进入，则说明没有相同的元素
-    node *tmp = new_node(obj);
+    node *tmp = new_node(batch, obj);
     tmp->next = first;
     buckets[n] = tmp;
     ++num_elements;
-    return pair<iterator, bool>(iterator(tmp, this), false);
+    return pair<iterator, bool>(iterator(tmp, this), true);
 }
 
 // 插入元素，不允许重复
 template<class V, class K, class HF, class Ex, class Eq, class A>
 typename hashtable<V, K, HF, Ex, Eq, A>::iterator
-hashtable<V, K, HF, Ex, Eq, A>::insert_equal_noresize(const value_type& obj)
+hashtable<V, K, HF, Ex, Eq, A>::insert_equal_noresize(const value_type& obj, node_batch* batch)
 {
     const size_type n = bkt_num(obj);
     node *first = buckets[n];   // 得到buckets头部
@@ -315,7 +447,7 @@ hashtable<V, K, HF, Ex, Eq, A>::insert_equal_noresize(const value_type& obj)
     {
         if(equals(get_key(cur->val), get_key(obj)))
         {
-            node *tmp = new_node(obj);
+            node *tmp = new_node(batch, obj);
             tmp->next = cur->next;
             cur->next = tmp;
             ++num_elements;
@@ -324,7 +456,7 @@ hashtable<V, K, HF, Ex, Eq, A>::insert_equal_noresize(const value_type& obj)
     }
 
     // 程序运行到这，说明没有key相等的元素
-    node *tmp = new_node(obj);
+    node *tmp = new_node(batch, obj);
     tmp->next = buckets[n];
     buckets[n] = tmp;
     ++num_elements;
@@ -334,18 +466,18 @@ hashtable<V, K, HF, Ex, Eq, A>::insert_equal_noresize(const value_type& obj)
 template<class V, class K, class HF, class Ex, class Eq, class A>
 void hashtable<V, K, HF, Ex, Eq, A>::copy_from(const hashtable<V, K, HF, Ex, Eq, A>& ht){
     clear();
-    // 对buckets进行resize()与ht.buckets一样的尺寸，容量大于则保留，容量小于则扩充
-    resize(ht.size());
-    // buckets已被clear(),buckets.end()就是开头
-    //buckets.insert(buckets.end(), ht.buckets.size(), (node *)0);
+    // buckets 与 ht.buckets 的尺寸必须一样，节点才能按原来的 bucket 复制
+    vector<node*, A> tmp(ht.buckets.size(), (node *)0, this->allocator());
+    buckets = std::move(tmp);
+    node_batch batch(*this, ht.num_elements);
     // 复制hashtable就是复制buckets以及buckets中的里面的链表元素
     for(size_type i = 0; i < ht.buckets.size(); ++i){
         if(const node *cur = ht.buckets[i]){
-            node *copy = new_node(cur->val);
+            node *copy = new_node(&batch, cur->val);
             buckets[i] = copy;
             
             for(node *next = cur->next; next;cur = next, next = cur->next){
-                copy->next = new_node(next->val);
+                copy->next = new_node(&batch, next->val);
                 copy = copy->next;
             }
         }
@@ -356,7 +488,8 @@ void hashtable<V, K, HF, Ex, Eq, A>::copy_from(const hashtable<V, K, HF, Ex, Eq,
 template<class V, class K, class HF, class Ex, class Eq, class A>
 typename hashtable<V, K, HF, Ex, Eq, A>::iterator
 hashtable<V, K, HF, Ex, Eq, A>::find(const key_type& key){
-    size_type n = bkt_num(key);
+    if(buckets.empty()) return end();     // 被移动后的表没有 bucket
+    size_type n = bkt_num_key(key);
     node *first = buckets[n];
     for(; first && !equals(get_key(first->val), key); first = first->next) {}
     return iterator(first, this);
@@ -365,7 +498,8 @@ hashtable<V, K, HF, Ex, Eq, A>::find(const key_type& key){
 template<class V, class K, class HF, class Ex, class Eq, class A>
 typename hashtable<V, K, HF, Ex, Eq, A>::size_type
 hashtable<V, K, HF, Ex, Eq, A>::count(const key_type& key) const {
-    size_type n = bkt_num(key);
+    if(buckets.empty()) return 0;
+    size_type n = bkt_num_key(key);
     size_type result = 0;
     for(const node* cur = buckets[n]; cur; cur = cur->next){
         if(equals(get_key(cur->val), key))
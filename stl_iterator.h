@@ -86,7 +86,7 @@ template <typename Iterator>
 inline typename iterator_traits<Iterator>::difference_type*
 distance_type(const Iterator&) {
     typedef typename iterator_traits<Iterator>::difference_type difference_type;
-    return difference_type();
+    return static_cast<difference_type*>(0);
 }
 
 /**
@@ -16,6 +16,7 @@ public:
     // 以下定义一个function，其作用调用 “元素比较函数”
     template<class Value = value_type>
     class value_compare {
+        friend class map;
     protected:
         Compare comp;
         value_compare(Compare c) : comp(c) {}
@@ -38,9 +39,11 @@ public:
     typedef typename rep_type::const_iterator   const_iterator;
     typedef typename rep_type::size_type    size_type;
     typedef typename rep_type::difference_type  difference_type;
+    typedef Alloc allocator_type;
 
     map() : t(Compare()) {}
     explicit map(const Compare& comp) : t(comp) {}
+    map(const Compare& comp, const Alloc& a) : t(comp, a) {}
 
     template<class InputerIterator>
     map(InputerIterator first, InputerIterator last) : t(Compare()) { t.insert_uniqual(first, last); }
@@ -49,18 +52,26 @@ public:
     map(InputerIterator first, InputerIterator last, const Compare& comp) : t(comp) { t.insert_uniqual(first, last); }
 
     map(const map<Key, T, Compare, Alloc>& x) : t(x.t) { }
+    map(map<Key, T, Compare, Alloc>&& x) : t(std::move(x.t)) { }
     map<Key, T, Compare, Alloc>& operator=(const map<Key, T, Compare, Alloc>& x) {
         t = x.t;
         return *this; 
     }
+    map<Key, T, Compare, Alloc>& operator=(map<Key, T, Compare, Alloc>&& x) {
+        t = std::move(x.t);
+        return *this;
+    }
+
+    void swap(map<Key, T, Compare, Alloc>& x) { t.swap(x.t); }
+    allocator_type get_allocator() const { return t.get_allocator(); }
 
     // 以下方法均调用rb_tree的接口
     key_compare key_comp() { return t.key_comp(); }
 
     //  value_compare value_comp() { return value_compare(t.key_comp()); }
     // 报错 value_compare 为模板类，编译器不允许函数返回类型中自动推导类型（即函数返回模板类时不能省略模板参数）
-    // 正确应该如下
-    value_compare<value_type> value_comp() { return value_compare(t.key_comp()); }
+    // 正确应该如下，构造时同样要写出模板参数
+    value_compare<value_type> value_comp() { return value_compare<value_type>(t.key_comp()); }
     iterator begin() { return t.begin(); }
     const_iterator begin() const { return t.begin(); }
     iterator end() { return t.end(); }
@@ -0,0 +1,257 @@
+#ifndef __STL_POOL_H
+#define __STL_POOL_H
+
+#include <string.h>
+#include "stl_alloc.h"
+
+/**
+ *  独立的内存池对象
+ *  与 __default_alloc_template 使用相同的大小类别，但 free list、chunk 与统计信息都属于对象本身，
+ *  每个分片(shard)或租户持有自己的 pool_resource，其容器的节点集中在自己的 chunk 中，统计信息互不干扰
+ *  超过 __MAX_BYTES 的请求交给第一级配置器，析构或 release() 时所有 chunk 一次性归还
+ *  pool_resource 不是线程安全的，一个 pool_resource 只能在一个线程中使用
+*/
+class pool_resource {
+private:
+    union obj {
+        union obj * free_list_link;
+        char client_data[1];
+    };
+
+    // 每个 chunk 头部的登记信息，大小为 __ALIGN 的倍数
+    struct chunk_header {
+        chunk_header * next;
+        size_t size;        // 包括 chunk_header 在内的字节数
+    };
+
+    obj * free_list[__NFREELISTS];
+    char * start_free;      // 内存池中尚未切分的空间
+    char * end_free;
+    chunk_header * chunk_list;
+    size_t heap_size;
+    alloc_stats counters;
+
+    pool_resource(const pool_resource &);
+    pool_resource & operator=(const pool_resource &);
+
+    void * refill(size_t i);
+    char * chunk_alloc(size_t size, int & nobjs);
+
+public:
+    pool_resource() : start_free(0), end_free(0), chunk_list(0), heap_size(0) {
+        memset(free_list, 0, sizeof(free_list));
+        memset(&counters, 0, sizeof(counters));
+    }
+
+    ~pool_resource() { release(); }
+
+    void * allocate(size_t n) {
+        if(n > (size_t)__MAX_BYTES) {
+            ++counters.large_allocs;
+            return malloc_alloc::allocate(n);
+        }
+        size_t i = __pool_size_class::index(n);
+        ++counters.allocs[i];
+        obj * result = free_list[i];
+        if(0 == result)
+            return refill(i);
+        free_list[i] = result->free_list_link;
+        return result;
+    }
+
+    void deallocate(void * p, size_t n) {
+        if(n > (size_t)__MAX_BYTES) {
+            ++counters.large_deallocs;
+            malloc_alloc::deallocate(p, n);
+            return;
+        }
+        size_t i = __pool_size_class::index(n);
+        ++counters.deallocs[i];
+        ((obj *)p)->free_list_link = free_list[i];
+        free_list[i] = (obj *)p;
+    }
+
+    // 配置 n 个字节时实际得到的字节数
+    static size_t good_size(size_t n) {
+        return n > (size_t)__MAX_BYTES ? malloc_alloc::good_size(n) : __pool_size_class::size(__pool_size_class::index(n));
+    }
+
+    // 一次配置 / 释放 count 个大小为 n 的区块
+    void allocate_batch(size_t n, size_t count, void ** out);
+    void deallocate_batch(size_t n, size_t count, void ** p);
+
+    // 归还所有 chunk，之前分配出去的区块全部失效；大区块不在 chunk 中，由使用者自己释放
+    void release();
+
+    // 取得统计快照，字段含义与 __default_alloc_template<inst>::get_stats() 相同
+    void get_stats(alloc_stats & s) const;
+};
+
+inline void * pool_resource::refill(size_t i) {
+    size_t n = __pool_size_class::size(i);
+    int nobjs = __pool_size_class::refill_count(n);
+    char * chunk = chunk_alloc(n, nobjs);
+
+    ++counters.refills[i];
+    // 第一块返回给调用者，其余串联成 free list
+    for(int k = nobjs - 1; k >= 1; --k) {
+        obj * current_obj = (obj *)(chunk + k * n);
+        current_obj->free_list_link = free_list[i];
+        free_list[i] = current_obj;
+    }
+    return chunk;
+}
+
+// size 已经是类别的区块大小，nobjs 通过引用传递，返回实际切出的区块数量
+inline char * pool_resource::chunk_alloc(size_t size, int & nobjs) {
+    size_t total_bytes = size * nobjs;
+    size_t bytes_left = end_free - start_free;
+
+    if(bytes_left < size) {
+        // 剩余的碎片依次交给不超过它的最大类别
+        while(bytes_left >= __ALIGN) {
+            size_t index = __pool_size_class::floor_index(bytes_left);
+            ((obj *)start_free)->free_list_link = free_list[index];
+            free_list[index] = (obj *)start_free;
+            start_free += __pool_size_class::size(index);
+            bytes_left -= __pool_size_class::size(index);
+        }
+
+        // 申请新的 chunk，失败时第一级配置器会调用 out of memory 处理函数
+        size_t bytes_to_get = 2 * total_bytes + __pool_size_class::align_up(heap_size >> 4);
+        size_t chunk_bytes = bytes_to_get + sizeof(chunk_header);
+        chunk_header * h = (chunk_header *)malloc_alloc::allocate(chunk_bytes);
+        ++counters.chunk_allocs;
+        h->size = chunk_bytes;
+        h->next = chunk_list;
+        chunk_list = h;
+        heap_size += bytes_to_get;
+        start_free = (char *)h + sizeof(chunk_header);
+        end_free = start_free + bytes_to_get;
+        bytes_left = bytes_to_get;
+    }
+
+    if(bytes_left < total_bytes) {
+        nobjs = bytes_left / size;
+        total_bytes = nobjs * size;
+    }
+    char * result = start_free;
+    start_free += total_bytes;
+    return result;
+}
+
+inline void pool_resource::allocate_batch(size_t n, size_t count, void ** out) {
+    size_t k = 0;
+    if(n > (size_t)__MAX_BYTES) {
+        counters.large_allocs += count;
+        for(; k < count; ++k)
+            out[k] = malloc_alloc::allocate(n);
+        return;
+    }
+    size_t i = __pool_size_class::index(n);
+    counters.allocs[i] += count;
+    obj * result = free_list[i];
+    for(; k < count && 0 != result; ++k, result = result->free_list_link)
+        out[k] = result;
+    free_list[i] = result;
+    // free list 不够时直接从内存池切出剩下的区块
+    size_t size = __pool_size_class::size(i);
+    while(k < count) {
+        int nobjs = (int)(count - k);
+        char * chunk = chunk_alloc(size, nobjs);
+        ++counters.refills[i];
+        for(int j = 0; j < nobjs; ++j)
+            out[k++] = chunk + j * size;
+    }
+}
+
+inline void pool_resource::deallocate_batch(size_t n, size_t count, void ** p) {
+    if(n > (size_t)__MAX_BYTES) {
+        counters.large_deallocs += count;
+        for(size_t k = 0; k < count; ++k)
+            malloc_alloc::deallocate(p[k], n);
+        return;
+    }
+    size_t i = __pool_size_class::index(n);
+    counters.deallocs[i] += count;
+    for(size_t k = 0; k < count; ++k) {
+        ((obj *)p[k])->free_list_link = free_list[i];
+        free_list[i] = (obj *)p[k];
+    }
+}
+
+inline void pool_resource::release() {
+    while(0 != chunk_list) {
+        chunk_header * next = chunk_list->next;
+        malloc_alloc::deallocate(chunk_list, chunk_list->size);
+        chunk_list = next;
+    }
+    memset(free_list, 0, sizeof(free_list));
+    start_free = end_free = 0;
+    heap_size = 0;
+}
+
+inline void pool_resource::get_stats(alloc_stats & s) const {
+    s = counters;
+    for(int i = 0; i < __NFREELISTS; ++i) {
+        size_t count = 0;
+        for(obj * p = free_list[i]; 0 != p; p = p->free_list_link)
+            ++count;
+        s.free_blocks[i] = count;
+        s.cached_blocks[i] = 0;
+    }
+    s.heap_size = heap_size;
+    s.pool_bytes = end_free - start_free;
+}
+
+/**
+ *  pool_allocator 是绑定某个 pool_resource 的有状态配置器，随容器保存
+ *  例如 map<Key, T, Compare, pool_allocator> m(Compare(), pool_allocator(shard_pool))
+ *  默认构造时不绑定 pool_resource，此时使用全局的 __default_alloc_template<0>
+ *  两个 pool_allocator 绑定同一个 pool_resource 时相等
+*/
+class pool_allocator {
+private:
+    pool_resource * pool;
+
+public:
+    pool_allocator() : pool(0) { }
+    explicit pool_allocator(pool_resource & p) : pool(&p) { }
+
+    void * allocate(size_t n) {
+        return pool ? pool->allocate(n) : __default_alloc_template<0>::allocate(n);
+    }
+
+    void deallocate(void * p, size_t n) {
+        if(pool)
+            pool->deallocate(p, n);
+        else
+            __default_alloc_template<0>::deallocate(p, n);
+    }
+
+    void allocate_batch(size_t n, size_t count, void ** out) {
+        if(pool)
+            pool->allocate_batch(n, count, out);
+        else
+            __default_alloc_template<0>::allocate_batch(n, count, out);
+    }
+
+    void deallocate_batch(size_t n, size_t count, void ** p) {
+        if(pool)
+            pool->deallocate_batch(n, count, p);
+        else
+            __default_alloc_template<0>::deallocate_batch(n, count, p);
+    }
+
+    static size_t good_size(size_t n) { return pool_resource::good_size(n); }
+
+    pool_resource * resource() const { return pool; }
+
+    bool operator==(const pool_allocator & x) const { return pool == x.pool; }
+    bool operator!=(const pool_allocator & x) const { return pool != x.pool; }
+};
+
+template<>
+struct __alloc_traits<pool_allocator> : public __stateful_alloc_traits<pool_allocator> { };
+
+#endif
@@ -300,14 +300,20 @@ inline void __rb_tree_reblance(__rb_tree_base_node* x, __rb_tree_base_node*& roo
     x->color = __rb_tree_black;
 }
 
+/**
+ *  rb_tree 继承自己的结点配置器，从而持有一个 Alloc 对象，复制、移动、交换时按照 __alloc_traits<Alloc> 的规则处理配置器
+*/
 template<class Key, class Value, class KeyOfValue, class Compare, class Alloc = __default_alloc_template<0> >
-class rb_tree
+class rb_tree : protected simple_alloc<__rb_tree_node<Value>, Alloc>
 {
 protected:
     typedef void* void_pointer;
     typedef __rb_tree_base_node* base_ptr;
     typedef __rb_tree_node<Value> rb_tree_node;
     typedef simple_alloc<rb_tree_node, Alloc> rb_tree_node_allocator;
+    typedef __alloc_traits<Alloc> alloc_traits;
+    typedef __node_batch<rb_tree_node, Alloc> node_batch;
+    typedef __node_release<rb_tree_node, Alloc> node_release;
     typedef __rb_tree_color_type color_type;
 
 public:
@@ -320,6 +326,7 @@ public:
     typedef rb_tree_node* link_type;
     typedef size_t size_type;
     typedef ptrdiff_t   difference_type;
+    typedef Alloc       allocator_type;
 
 protected:
     link_type get_node() { return rb_tree_node_allocator::allocate(); }
@@ -333,9 +340,23 @@ protected:
         return tmp;
     }
 
+    // 从 batch 中取出结点并构造，batch 为 0 时单独配置
+    link_type create_node(node_batch* batch, const Value& x) {
+        if(batch == 0)
+            return create_node(x);
+        link_type tmp = batch->get();
+        try {
+            construct(&tmp->value_field, x);
+        } catch(...) {
+            batch->put(tmp);
+            throw;
+        }
+        return tmp;
+    }
+
     // 复制一个结点的 值 和 色
-    link_type clone_node(link_type x) {
-        link_type tmp = create_node(x->value_field);
+    link_type clone_node(link_type x, node_batch* batch = 0) {
+        link_type tmp = create_node(batch, x->value_field);
         tmp->color = x->color;
         tmp->left = 0;
         tmp->right = 0;
@@ -348,6 +369,12 @@ protected:
         put_node(p);
     }
 
+    void release_nodes(__true_type) { }
+    void release_nodes(__false_type) {
+        node_release released(*this);
+        __erase(root(), released);
+    }
+
 protected:
     // RB-tree存储header的指针, 并只用三个数据表示整颗RB-tree
     size_type node_count;
@@ -386,9 +413,11 @@ public:
     typedef __rb_tree_iterator<value_type, const_reference, const_pointer> const_iterator;
 
 private:
-    iterator __insert(base_ptr x, base_ptr y, const value_type& v);
-    link_type __copy(link_type x, link_type p);
-    void __erase(link_type x);
+    iterator __insert(base_ptr x, base_ptr y, const value_type& v, node_batch* batch = 0);
+    link_type __copy(link_type x, link_type p, node_batch& batch);
+    pair<iterator, bool> __insert_unique(const value_type& v, node_batch* batch);
+    iterator __insert_equal(const value_type& v, node_batch* batch);
+    void __erase(link_type x, node_release& released);
 
     void init() {
         header = get_node();
@@ -399,17 +428,46 @@ private:
         rightmost() = header;
     }
 
+    // 复制 rb 的所有结点，*this 必须为空树
+    void copy_from(const rb_tree& rb) {
+        if(rb.root() == nullptr) return;
+        node_batch batch(*this, rb.node_count);
+        root() = __copy(rb.root(), header, batch);
+        leftmost() = minimum(root());
+        rightmost() = maximum(root());
+        node_count = rb.node_count;
+    }
+
+    // 交换 header 与结点数量，不交换配置器
+    void swap_nodes(rb_tree& x) {
+        link_type tmp = header;
+        header = x.header;
+        x.header = tmp;
+        size_type n = node_count;
+        node_count = x.node_count;
+        x.node_count = n;
+    }
+
 public:
     rb_tree(const Compare& comp = Compare() ) : node_count(0), key_compare(comp) { init(); }
-    rb_tree(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rb) : node_count(0), key_compare(Compare()) {
+    rb_tree(const Compare& comp, const Alloc& a) : rb_tree_node_allocator(a), node_count(0), key_compare(comp) { init(); }
+    rb_tree(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rb)
+        : rb_tree_node_allocator(alloc_traits::select_on_copy_construction(rb.allocator())), node_count(0), key_compare(rb.key_compare) {
         init();
-        if(rb.root() == nullptr) return;
-        else {
-            root() = __copy(rb.root(), header);
-            leftmost() = minimum(root());
-            rightmost() = minimum(root());
-        }
-        node_count = rb.node_count;
+        copy_from(rb);
+    }
+
+    rb_tree(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rb, const Alloc& a)
+        : rb_tree_node_allocator(a), node_count(0), key_compare(rb.key_compare) {
+        init();
+        copy_from(rb);
+    }
+
+    // 移动构造，与 rb 交换 header，rb 留下新配置的空树
+    rb_tree(rb_tree<Key, Value, KeyOfValue, Compare, Alloc>&& rb)
+        : rb_tree_node_allocator(rb.allocator()), node_count(0), key_compare(rb.key_compare) {
+        init();
+        swap_nodes(rb);
     }
 
     ~rb_tree() { 
@@ -420,17 +478,41 @@ public:
     rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& operator=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& x) {
         if(this != &x) {
             clear(); // 以前的树
-            key_compare = x.key_compare;
-            if(x.root()) {
-                header = x.header;
-                node_count = x.node_count;
-            }else {
+            if(__alloc_copy_changes(this->allocator(), x.allocator())) {
+                // header 也要交还给原来的配置器
+                put_node(header);
+                __alloc_copy_assign(this->allocator(), x.allocator());
                 init();
             }
+            key_compare = x.key_compare;
+            copy_from(x);
+        }
+        return *this;
+    }
+
+    rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& operator=(rb_tree<Key, Value, KeyOfValue, Compare, Alloc>&& x) {
+        if(this != &x) {
+            clear();
+            key_compare = x.key_compare;
+            if(__alloc_move_steals(this->allocator(), x.allocator())) {
+                // header 与配置器一起交换，原来的空 header 随 x 由原来的配置器释放
+                __alloc_swap(this->allocator(), x.allocator(), __true_type());
+                swap_nodes(x);
+            } else {
+                copy_from(x);
+            }
         }
         return *this;
     }
 
+    void swap(rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& x) {
+        __alloc_swap(this->allocator(), x.allocator());
+        swap_nodes(x);
+        std::swap(key_compare, x.key_compare);
+    }
+
+    allocator_type get_allocator() const { return this->allocator(); }
+
 public:
     Compare key_comp() const { return key_compare; }
     iterator begin() const { return leftmost(); }
@@ -439,9 +521,12 @@ public:
     size_type size() const { return node_count; }
     void clear();   // 清空整个树
 
-    iterator insert_equal(const value_type& v);
+    iterator insert_equal(const value_type& v) { return __insert_equal(v, 0); }
+    template<class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last);
 
-    pair<iterator, bool> insert_uniqual(const value_type& x);
+    pair<iterator, bool> insert_uniqual(const value_type& x) { return __insert_unique(x, 0); }
+    // 区间插入，结点成批配置
     template<class InputerIterator>
     void insert_uniqual(InputerIterator first, InputerIterator last);
 
@@ -453,8 +538,8 @@ template<class Key, class Value, class KeyofValue, class Compare, class Alloc>
 void rb_tree<Key, Value, KeyofValue, Compare, Alloc>::clear() {
     // 使rb_tree回归无结点状态
     if(node_count != 0) {
-        // 清除除header以外的所有结点
-        __erase(root());
+        // 清除除header以外的所有结点，节点空间由配置器整体回收时不需要遍历
+        release_nodes(typename __node_teardown<Value, Alloc>::skip());
         // 使rb_tree回归无结点状态
         leftmost() = header;
         root() = nullptr;
@@ -490,20 +575,29 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::find(const Key& k) {
 
 template<class Key, class Value, class KeyofValue, class Compare, class Alloc>
 typename rb_tree<Key, Value, KeyofValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyofValue, Compare, Alloc>::insert_equal(const value_type& v) {
+rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__insert_equal(const value_type& v, node_batch* batch) {
     link_type y = header;
     link_type x = root();
     while(x != 0)
     {
         y = x;
-        x = key_compare(KeyofValue()(v), key(x)) ? y->left : y->right;
+        x = key_compare(KeyofValue()(v), key(x)) ? left(y) : right(y);
     }
-    return __insert(x, y, v);
+    return __insert(x, y, v, batch);
+}
+
+template<class Key, class Value, class KeyofValue, class Compare, class Alloc>
+template <typename InputIterator>
+void rb_tree<Key, Value, KeyofValue, Compare, Alloc>::insert_equal(InputIterator first, InputIterator last)
+{
+    node_batch batch(*this, __batch_hint(first, last));
+    for(; first != last; ++first)
+        __insert_equal(*first, &batch);
 }
 
 template<class Key, class Value, class  KeyofValue, class Compare, class Alloc>
 pair<typename rb_tree<Key, Value, KeyofValue, Compare, Alloc>::iterator, bool>
-rb_tree<Key, Value, KeyofValue, Compare, Alloc>::insert_uniqual(const value_type& v)
+rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__insert_unique(const value_type& v, node_batch* batch)
 {
     link_type y = header;
     link_type x = root();
@@ -519,12 +613,12 @@ rb_tree<Key, Value, KeyofValue, Compare, Alloc>::insert_uniqual(const value_type
     iterator j = iterator(y);
     if(comp)
         if(j == begin())
-            return pair<iterator, bool>(__insert(x, y, v), true);
+            return pair<iterator, bool>(__insert(x, y, v, batch), true);
         else
             --j;
 
     if( key_compare(key(j.node), KeyofValue()(v)) )
-        return pair<iterator, bool>(__insert(x, y, v), true);
+        return pair<iterator, bool>(__insert(x, y, v, batch), true);
     
     return pair<iterator, bool>(j, false);
 }
@@ -533,13 +627,15 @@ template<class Key, class Value, class KeyofValue, class Compare, class Alloc>
 template <typename InputIterator>
 void rb_tree<Key, Value, KeyofValue, Compare, Alloc>::insert_uniqual(InputIterator first, InputIterator last)
 {
+    // 重复的元素不会取用结点，剩下的结点在 batch 析构时一次归还
+    node_batch batch(*this, __batch_hint(first, last));
     for(; first != last; ++first)
-        insert_uniqual(*first);
+        __insert_unique(*first, &batch);
 }
 
 template<class Key, class Value, class KeyofValue, class Compare, class Alloc>
 typename rb_tree<Key, Value, KeyofValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__insert(base_ptr x__, base_ptr y__, const value_type& v)
+rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__insert(base_ptr x__, base_ptr y__, const value_type& v, node_batch* batch)
 {
     link_type x = (link_type)x__;
     link_type y = (link_type)y__;
@@ -547,7 +643,7 @@ rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__insert(base_ptr x__, base_ptr
 
     // key_compare 是键值大小比较函数，应该是个function object
     if( y == header || x != 0 || key_compare(KeyofValue()(v), key(y)) ) {
-        z = create_node(v);
+        z = create_node(batch, v);
         left(y) = z;
         if(y == header) {
             root() = z;
@@ -558,7 +654,7 @@ rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__insert(base_ptr x__, base_ptr
             leftmost() = z;
         }
     }else {
-        z = create_node(v);
+        z = create_node(batch, v);
         right(y) = z;
         if(rightmost() == y) {
             rightmost() = z;
@@ -579,25 +675,25 @@ rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__insert(base_ptr x__, base_ptr
 */
 template<class Key, class Value, class KeyOfValue, class Compar, class Alloc>
 typename rb_tree<Key, Value, KeyOfValue, Compar, Alloc>::link_type
-rb_tree<Key, Value, KeyOfValue, Compar, Alloc>::__copy(link_type x, link_type p) {
-    link_type top = clone_node(x);
+rb_tree<Key, Value, KeyOfValue, Compar, Alloc>::__copy(link_type x, link_type p, node_batch& batch) {
+    link_type top = clone_node(x, &batch);
     top->parent = p;
     // 节点创建错误防止内存泄漏
     try {
         // 由于左节点深度一般都比右节点深度大，因此为了性能优化，对右节点使用递归处理
         // 对左节点使用循环处理
         if( x->right )
-            top->right = __copy(right(x), top);
+            top->right = __copy(right(x), top, batch);
 
         p = top;
         x = left(x);
         // 对左节点循环处理
         while(x != nullptr) {
-            link_type y = clone_node(x);
+            link_type y = clone_node(x, &batch);
             p->left = y;
             y->parent = p;
             if( x->right )
-                y->right = __copy(right(x), y);
+                y->right = __copy(right(x), y, batch);
             p = y;
             x = left(x);
         }
@@ -609,14 +705,16 @@ rb_tree<Key, Value, KeyOfValue, Compar, Alloc>::__copy(link_type x, link_type p)
 }
 
 template <class Key, class Value, class KeyofValue, class Compare, class Alloc>
-void rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__erase(link_type x) {
+void rb_tree<Key, Value, KeyofValue, Compare, Alloc>::__erase(link_type x, node_release& released) {
     // 递归地调用__erase清除右孩子结点
     // 循环地清除左孩子结点
     // 因为左孩子一般比右孩子多，因此一般右孩子递归，左孩子循环这样可以使代码与效率最平衡
+    // 结点析构后交给 released 成批归还
     while(x != nullptr) {
-        __erase( right(x) );
+        __erase( right(x), released );
         link_type y = left(x);
-        destroy_node(x);
+        destroy(&(x->value_field));
+        released.put(x);
         x = y;
     }
 }
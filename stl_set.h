@@ -3,6 +3,7 @@
 
 #include "stl_rb_tree.h"
 #include "stl_function.h"
+#include "algo.h"
 
 template<class Key, class Compare = std::less<Key>, class Alloc = __default_alloc_template<0>>
 class set 
@@ -35,11 +36,13 @@ public:
     typedef typename rep_type::const_iterator  const_iterator;
     typedef typename rep_type::size_type  size_type;
     typedef typename rep_type::difference_type difference_type;
+    typedef Alloc allocator_type;
 
     // 由于set的性质，不允许重复的元素，且Key = Value
     // RB_tree 作为set的底层容器，则set调用RB_tree的底层函数insert_unique()，不允许插入重复元素
     set() : t(Compare()) { }
     explicit set(const Compare& comp) : t(comp) { }
+    set(const Compare& comp, const Alloc& a) : t(comp, a) { }
 
     // 输入两个迭代器，将[first, last)插入set之中
     template<class InputIterator>
@@ -49,11 +52,16 @@ public:
     set(InputIterator first, InputIterator last, const Compare& comp) : t(comp) { t.insert_uniqual(first, last); }
     // 复制构造函数
     set(const set<Key, Compare, Alloc> &x) : t(x.t) { }
+    set(set<Key, Compare, Alloc> &&x) : t(std::move(x.t)) { }
 
-    // set<Key, Compare, Alloc>& operator=(const set<key, Compare, Alloc> &x) {
-    //     t = x.t;
-    //     return *this;
-    // }
+    set<Key, Compare, Alloc>& operator=(const set<Key, Compare, Alloc> &x) {
+        t = x.t;
+        return *this;
+    }
+    set<Key, Compare, Alloc>& operator=(set<Key, Compare, Alloc> &&x) {
+        t = std::move(x.t);
+        return *this;
+    }
 
 public:
     // 以下操作完全在rb_tree t 中已经提供
@@ -63,26 +71,31 @@ public:
     iterator end() const { return t.end(); }
     bool empty() const { return t.empty(); }
     size_type size() const { return t.size(); }
-    // void swap(set<Key, Compare, Alloc>& x) { t.swap(x.t); }
+    void swap(set<Key, Compare, Alloc>& x) { t.swap(x.t); }
+    allocator_type get_allocator() const { return t.get_allocator(); }
+
+    // 返回一个pair<iterator, bool> ： <插入元素的迭代器，是否真的插入>
+    pair<iterator, bool> insert(const value_type& x) {
+        pair<typename rep_type::iterator, bool> p = t.insert_uniqual(x);
+        return pair<iterator, bool>(p.first, p.second);
+    }
+
+    template<class InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_uniqual(first, last);
+    }
 
     void clear() { t.clear(); }
     // set operator
     iterator find(const value_type& x) { return t.find(x); }
 
-    // // 友元函数定义
-    friend bool operator== (const set&, const set&);
-    friend bool operator< (const set&, const set&);
-    
+    // 友元函数定义，元素个数相同且逐个相等时两个 set 相等，大小按字典序比较
+    friend bool operator== (const set& x, const set& y) {
+        return x.size() == y.size() && MYSTL::equal(x.begin(), x.end(), y.begin());
+    }
+    friend bool operator< (const set& x, const set& y) {
+        return MYSTL::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+    }
 };
 
-template<class Key, class Compare, class Alloc>
-inline bool operator==(const set<Key, Compare, Alloc>& x, const set<Key, Compare, Alloc>& y) {
-    return x.t == y.t;
-}
-
-template<class Key, class Compare, class Alloc>
-inline operator<(const set<Key, Compare, Alloc>& x, const set<Key, Compare, Alloc>& y) {
-    return x.t < y.t;
-}
-
 #endif
@@ -0,0 +1,365 @@
+#ifndef __STL_SIMD_H
+#define __STL_SIMD_H
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "type_traits.h"
+#include "stl_function.h"
+
+/**
+ *  连续空间上的向量化算法，供 algo.h 中 fill()/find()/find_if()/count()/count_if()/mismatch()/equal()
+ *  针对原生指针的版本调用：
+ *      每次处理 16(SSE2) 或 32(AVX2) 个字节，比较结果通过 movemask 压成位图，再用 ctz/popcount 求出位置或个数，
+ *      不足一个向量的尾部逐个元素处理
+ *      是否支持 AVX2 在运行时通过 CPUID 判断(只判断一次)，编译时不需要 -mavx2；SSE2 是 x86-64 的基本指令集
+ *      不是 x86、没有 SSE2 或者编译器不是 GCC/Clang 时只有逐个元素的版本
+ *  比较按位进行，只适用于整数(不含 bool)；浮点数的 NaN 与 +0/-0 按位比较与 == 的结果不同，只做填充
+*/
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+#define __STL_SIMD
+#include <immintrin.h>
+#define __STL_AVX2 __attribute__((target("avx2")))
+#endif
+
+// 与元素同样大小的无符号整数，向量化的版本按位处理元素
+template<size_t S> struct __simd_word;
+template<> struct __simd_word<1> { typedef unsigned char type; };
+template<> struct __simd_word<2> { typedef unsigned short type; };
+template<> struct __simd_word<4> { typedef unsigned int type; };
+template<> struct __simd_word<8> { typedef unsigned long long type; };
+
+template<typename T>
+inline typename __simd_word<sizeof(T)>::type __simd_bits(const T& x) {
+    typename __simd_word<sizeof(T)>::type w;
+    memcpy(&w, &x, sizeof(T));
+    return w;
+}
+
+// 可以按位比较的元素：1、2、4、8 字节的整数，不含 bool 与 volatile
+template<typename T>
+struct __simd_integer : public std::integral_constant<bool,
+    std::is_integral<T>::value && !std::is_volatile<T>::value &&
+    !std::is_same<typename std::remove_cv<T>::type, bool>::value &&
+    (1 == sizeof(T) || 2 == sizeof(T) || 4 == sizeof(T) || 8 == sizeof(T))> { };
+
+// 可以按位填充的元素：1、2、4、8 字节的算术类型，不含 const 与 volatile
+template<typename T>
+struct __simd_fillable : public std::integral_constant<bool,
+    std::is_arithmetic<T>::value && !std::is_const<T>::value && !std::is_volatile<T>::value &&
+    (1 == sizeof(T) || 2 == sizeof(T) || 4 == sizeof(T) || 8 == sizeof(T))> { };
+
+/**
+ *  逐个元素的版本，也用于向量化版本的尾部
+ *  mismatch 返回 [first1, last1) 中第一个与 first2 对应元素不相等的位置
+*/
+template<int Op, typename T>
+inline const T* __find_scalar(const T* first, const T* last, T value) {
+    __compare_to_value<T, Op> pred(value);
+    while(first != last && !pred(*first))
+        ++first;
+    return first;
+}
+
+template<int Op, typename T>
+inline size_t __count_scalar(const T* first, const T* last, T value) {
+    __compare_to_value<T, Op> pred(value);
+    size_t n = 0;
+    for(; first != last; ++first)
+        if(pred(*first)) ++n;
+    return n;
+}
+
+template<typename T>
+inline const T* __mismatch_scalar(const T* first1, const T* last1, const T* first2) {
+    while(first1 != last1 && *first1 == *first2)
+        ++first1, ++first2;
+    return first1;
+}
+
+template<typename T>
+inline void __fill_scalar(T* first, T* last, T value) {
+    for(; first != last; ++first)
+        *first = value;
+}
+
+#ifdef __STL_SIMD
+
+// 运行时查询 CPU 是否支持 AVX2，结果缓存在静态变量中
+inline bool __simd_has_avx2() {
+    static const bool avx2 = (__builtin_cpu_init(), 0 != __builtin_cpu_supports("avx2"));
+    return avx2;
+}
+
+// 无符号整数做大小比较时先翻转符号位，再用有符号的比较指令
+template<int Op, typename T>
+struct __simd_bias : public std::integral_constant<bool,
+    (__cmp_lt == Op || __cmp_gt == Op) && !std::is_signed<T>::value> { };
+
+/**
+ *  SSE2：按元素大小选择比较指令，eq/gt 的结果每个元素全为 1 或全为 0
+ *  SSE2 没有 64 位比较：相等时把两半 32 位的比较结果相与，大小比较不支持(ordered 为 false)，交给逐个元素的版本
+*/
+template<size_t S> struct __sse2;
+
+template<> struct __sse2<1> {
+    static const bool ordered = true;
+    static __m128i set1(unsigned char x) { return _mm_set1_epi8((char)x); }
+    static __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+    static __m128i gt(__m128i a, __m128i b) { return _mm_cmpgt_epi8(a, b); }
+};
+
+template<> struct __sse2<2> {
+    static const bool ordered = true;
+    static __m128i set1(unsigned short x) { return _mm_set1_epi16((short)x); }
+    static __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+    static __m128i gt(__m128i a, __m128i b) { return _mm_cmpgt_epi16(a, b); }
+};
+
+template<> struct __sse2<4> {
+    static const bool ordered = true;
+    static __m128i set1(unsigned int x) { return _mm_set1_epi32((int)x); }
+    static __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+    static __m128i gt(__m128i a, __m128i b) { return _mm_cmpgt_epi32(a, b); }
+};
+
+template<> struct __sse2<8> {
+    static const bool ordered = false;
+    static __m128i set1(unsigned long long x) { return _mm_set1_epi64x((long long)x); }
+    static __m128i eq(__m128i a, __m128i b) {
+        __m128i t = _mm_cmpeq_epi32(a, b);
+        return _mm_and_si128(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+};
+
+// 比较结果的位图，每个字节一位，满足条件的元素对应的位全为 1
+template<int Op> struct __sse2_cmp;
+template<> struct __sse2_cmp<__cmp_eq> {
+    template<size_t S> static unsigned mask(__m128i x, __m128i v) { return _mm_movemask_epi8(__sse2<S>::eq(x, v)); }
+};
+template<> struct __sse2_cmp<__cmp_ne> {
+    template<size_t S> static unsigned mask(__m128i x, __m128i v) { return _mm_movemask_epi8(__sse2<S>::eq(x, v)) ^ 0xFFFFu; }
+};
+template<> struct __sse2_cmp<__cmp_lt> {
+    template<size_t S> static unsigned mask(__m128i x, __m128i v) { return _mm_movemask_epi8(__sse2<S>::gt(v, x)); }
+};
+template<> struct __sse2_cmp<__cmp_gt> {
+    template<size_t S> static unsigned mask(__m128i x, __m128i v) { return _mm_movemask_epi8(__sse2<S>::gt(x, v)); }
+};
+
+template<int Op, typename T>
+inline __m128i __sse2_bias() {
+    typedef typename __simd_word<sizeof(T)>::type word;
+    return __simd_bias<Op, T>::value ? __sse2<sizeof(T)>::set1(word(1) << (8 * sizeof(T) - 1)) : _mm_setzero_si128();
+}
+
+template<int Op, typename T>
+inline const T* __find_sse2(const T* first, const T* last, T value, __true_type) {
+    const size_t n = 16 / sizeof(T);
+    const __m128i b = __sse2_bias<Op, T>();
+    const __m128i v = _mm_xor_si128(__sse2<sizeof(T)>::set1(__simd_bits(value)), b);
+    for(; size_t(last - first) >= n; first += n) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)first), b);
+        unsigned m = __sse2_cmp<Op>::template mask<sizeof(T)>(x, v);
+        if(m) return first + __builtin_ctz(m) / sizeof(T);
+    }
+    return __find_scalar<Op>(first, last, value);
+}
+
+template<int Op, typename T>
+inline const T* __find_sse2(const T* first, const T* last, T value, __false_type)
+{ return __find_scalar<Op>(first, last, value); }
+
+template<int Op, typename T>
+inline size_t __count_sse2(const T* first, const T* last, T value, __true_type) {
+    const size_t n = 16 / sizeof(T);
+    const __m128i b = __sse2_bias<Op, T>();
+    const __m128i v = _mm_xor_si128(__sse2<sizeof(T)>::set1(__simd_bits(value)), b);
+    size_t bits = 0;
+    for(; size_t(last - first) >= n; first += n) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)first), b);
+        bits += __builtin_popcount(__sse2_cmp<Op>::template mask<sizeof(T)>(x, v));
+    }
+    return bits / sizeof(T) + __count_scalar<Op>(first, last, value);
+}
+
+template<int Op, typename T>
+inline size_t __count_sse2(const T* first, const T* last, T value, __false_type)
+{ return __count_scalar<Op>(first, last, value); }
+
+template<typename T>
+inline const T* __mismatch_sse2(const T* first1, const T* last1, const T* first2) {
+    const size_t n = 16 / sizeof(T);
+    for(; size_t(last1 - first1) >= n; first1 += n, first2 += n) {
+        __m128i x = _mm_loadu_si128((const __m128i*)first1);
+        __m128i y = _mm_loadu_si128((const __m128i*)first2);
+        unsigned m = __sse2_cmp<__cmp_ne>::template mask<sizeof(T)>(x, y);
+        if(m) return first1 + __builtin_ctz(m) / sizeof(T);
+    }
+    return __mismatch_scalar(first1, last1, first2);
+}
+
+template<typename T>
+inline void __fill_sse2(T* first, T* last, T value) {
+    const size_t n = 16 / sizeof(T);
+    const __m128i v = __sse2<sizeof(T)>::set1(__simd_bits(value));
+    for(; size_t(last - first) >= n; first += n)
+        _mm_storeu_si128((__m128i*)first, v);
+    __fill_scalar(first, last, value);
+}
+
+/**
+ *  AVX2：与 SSE2 的版本相同，每次处理 32 个字节，64 位元素也有比较指令
+ *  所有函数都带 target("avx2")，只在 __simd_has_avx2() 为 true 时调用
+*/
+template<size_t S> struct __avx2;
+
+template<> struct __avx2<1> {
+    __STL_AVX2 static __m256i set1(unsigned char x) { return _mm256_set1_epi8((char)x); }
+    __STL_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi8(a, b); }
+    __STL_AVX2 static __m256i gt(__m256i a, __m256i b) { return _mm256_cmpgt_epi8(a, b); }
+};
+
+template<> struct __avx2<2> {
+    __STL_AVX2 static __m256i set1(unsigned short x) { return _mm256_set1_epi16((short)x); }
+    __STL_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi16(a, b); }
+    __STL_AVX2 static __m256i gt(__m256i a, __m256i b) { return _mm256_cmpgt_epi16(a, b); }
+};
+
+template<> struct __avx2<4> {
+    __STL_AVX2 static __m256i set1(unsigned int x) { return _mm256_set1_epi32((int)x); }
+    __STL_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(a, b); }
+    __STL_AVX2 static __m256i gt(__m256i a, __m256i b) { return _mm256_cmpgt_epi32(a, b); }
+};
+
+template<> struct __avx2<8> {
+    __STL_AVX2 static __m256i set1(unsigned long long x) { return _mm256_set1_epi64x((long long)x); }
+    __STL_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi64(a, b); }
+    __STL_AVX2 static __m256i gt(__m256i a, __m256i b) { return _mm256_cmpgt_epi64(a, b); }
+};
+
+template<int Op> struct __avx2_cmp;
+template<> struct __avx2_cmp<__cmp_eq> {
+    template<size_t S> __STL_AVX2 static unsigned mask(__m256i x, __m256i v) { return _mm256_movemask_epi8(__avx2<S>::eq(x, v)); }
+};
+template<> struct __avx2_cmp<__cmp_ne> {
+    template<size_t S> __STL_AVX2 static unsigned mask(__m256i x, __m256i v) { return ~(unsigned)_mm256_movemask_epi8(__avx2<S>::eq(x, v)); }
+};
+template<> struct __avx2_cmp<__cmp_lt> {
+    template<size_t S> __STL_AVX2 static unsigned mask(__m256i x, __m256i v) { return _mm256_movemask_epi8(__avx2<S>::gt(v, x)); }
+};
+template<> struct __avx2_cmp<__cmp_gt> {
+    template<size_t S> __STL_AVX2 static unsigned mask(__m256i x, __m256i v) { return _mm256_movemask_epi8(__avx2<S>::gt(x, v)); }
+};
+
+template<int Op, typename T>
+__STL_AVX2 inline __m256i __avx2_bias() {
+    typedef typename __simd_word<sizeof(T)>::type word;
+    return __simd_bias<Op, T>::value ? __avx2<sizeof(T)>::set1(word(1) << (8 * sizeof(T) - 1)) : _mm256_setzero_si256();
+}
+
+template<int Op, typename T>
+__STL_AVX2 const T* __find_avx2(const T* first, const T* last, T value) {
+    const size_t n = 32 / sizeof(T);
+    const __m256i b = __avx2_bias<Op, T>();
+    const __m256i v = _mm256_xor_si256(__avx2<sizeof(T)>::set1(__simd_bits(value)), b);
+    for(; size_t(last - first) >= n; first += n) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)first), b);
+        unsigned m = __avx2_cmp<Op>::template mask<sizeof(T)>(x, v);
+        if(m) return first + __builtin_ctz(m) / sizeof(T);
+    }
+    return __find_scalar<Op>(first, last, value);
+}
+
+template<int Op, typename T>
+__STL_AVX2 size_t __count_avx2(const T* first, const T* last, T value) {
+    const size_t n = 32 / sizeof(T);
+    const __m256i b = __avx2_bias<Op, T>();
+    const __m256i v = _mm256_xor_si256(__avx2<sizeof(T)>::set1(__simd_bits(value)), b);
+    size_t bits = 0;
+    for(; size_t(last - first) >= n; first += n) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)first), b);
+        bits += __builtin_popcount(__avx2_cmp<Op>::template mask<sizeof(T)>(x, v));
+    }
+    return bits / sizeof(T) + __count_scalar<Op>(first, last, value);
+}
+
+template<typename T>
+__STL_AVX2 const T* __mismatch_avx2(const T* first1, const T* last1, const T* first2) {
+    const size_t n = 32 / sizeof(T);
+    for(; size_t(last1 - first1) >= n; first1 += n, first2 += n) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)first1);
+        __m256i y = _mm256_loadu_si256((const __m256i*)first2);
+        unsigned m = __avx2_cmp<__cmp_ne>::template mask<sizeof(T)>(x, y);
+        if(m) return first1 + __builtin_ctz(m) / sizeof(T);
+    }
+    return __mismatch_scalar(first1, last1, first2);
+}
+
+template<typename T>
+__STL_AVX2 void __fill_avx2(T* first, T* last, T value) {
+    const size_t n = 32 / sizeof(T);
+    const __m256i v = __avx2<sizeof(T)>::set1(__simd_bits(value));
+    for(; size_t(last - first) >= n; first += n)
+        _mm256_storeu_si256((__m256i*)first, v);
+    __fill_scalar(first, last, value);
+}
+
+#endif /* __STL_SIMD */
+
+/**
+ *  algo.h 调用的入口：有 AVX2 时用 AVX2，否则用 SSE2，都没有时逐个元素处理
+ *  Op 为 __compare_op，find/count 求满足 x Op value 的元素
+*/
+template<int Op, typename T>
+inline const T* __simd_find(const T* first, const T* last, T value) {
+#ifdef __STL_SIMD
+    if(__simd_has_avx2())
+        return __find_avx2<Op>(first, last, value);
+    typedef typename __bool_type<__sse2<sizeof(T)>::ordered || __cmp_eq == Op || __cmp_ne == Op>::type supported;
+    return __find_sse2<Op>(first, last, value, supported());
+#else
+    return __find_scalar<Op>(first, last, value);
+#endif
+}
+
+template<int Op, typename T>
+inline size_t __simd_count(const T* first, const T* last, T value) {
+#ifdef __STL_SIMD
+    if(__simd_has_avx2())
+        return __count_avx2<Op>(first, last, value);
+    typedef typename __bool_type<__sse2<sizeof(T)>::ordered || __cmp_eq == Op || __cmp_ne == Op>::type supported;
+    return __count_sse2<Op>(first, last, value, supported());
+#else
+    return __count_scalar<Op>(first, last, value);
+#endif
+}
+
+template<typename T>
+inline const T* __simd_mismatch(const T* first1, const T* last1, const T* first2) {
+#ifdef __STL_SIMD
+    if(__simd_has_avx2())
+        return __mismatch_avx2(first1, last1, first2);
+    return __mismatch_sse2(first1, last1, first2);
+#else
+    return __mismatch_scalar(first1, last1, first2);
+#endif
+}
+
+template<typename T>
+inline void __simd_fill(T* first, T* last, T value) {
+    if(1 == sizeof(T)) {
+        memset(first, __simd_bits(value), last - first);
+        return;
+    }
+#ifdef __STL_SIMD
+    if(__simd_has_avx2())
+        return __fill_avx2(first, last, value);
+    __fill_sse2(first, last, value);
+#else
+    __fill_scalar(first, last, value);
+#endif
+}
+
+#endif
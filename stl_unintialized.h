@@ -2,12 +2,16 @@
 #define _STL_UNINTIALIZED_H
 
 #include "stl_construct.h"
+#include "stl_pair.h"
 #include "algo.h"
 
 /**
  * unintialized_copy()  fill()  full_n()类型特例化
  * 对于 POD 类型拥有 cont()/dcot()/assigment()任务调用 STL 的高级函数
  * 使用taite_type()
+ *
+ * 以下函数都是 commit or rollback：构造某个元素时抛出异常，已经构造的元素全部析构，异常继续向外抛出
+ * 元素类型一律通过 iterator_traits 取得，不要求元素可以默认构造
 */
 
 /**
@@ -16,7 +20,7 @@
 template<typename InputIterator, typename ForwardIterator>
 inline ForwardIterator __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator result, __true_type)
 {
-    // POD类型调用STL高级函数
+    // POD类型调用STL高级函数，原生指针时为 memmove
     return MYSTL::copy(first, last, result);
 }
 
@@ -25,26 +29,235 @@ template<typename InputIterator, typename ForwardIterator>
 inline ForwardIterator __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
 {
     ForwardIterator cur = result;
-    for(; first != last; ++first, ++cur)
-    {
-        construct(&*(cur), *first);
+    try {
+        for(; first != last; ++first, ++cur)
+            construct(&*cur, *first);
+    } catch(...) {
+        destroy(result, cur);
+        throw;
     }
     return cur;
 }
 
-template<typename InputIterator, typename ForwardIterator, typename T>
-inline ForwardIterator __uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result, T )
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result)
 {
     // trait_typed()实现分辨是否为POD类型
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
     typedef typename __type_traits<T>::is_POD_type is_POD;
     //__aux实现实际操作，并针对is_POD进行特殊处理
     return __uninitialized_copy_aux(first, last, result, is_POD());
 }
 
+/**
+ *  uninitialized_move()  uninitialized_move_n()
+ *  将 [first, last) 的元素移动构造到 result 开始的未初始化空间，原元素仍需由调用者析构
+ *  POD 类型的移动就是复制，交给 uninitialized_copy()
+ *  uninitialized_move_if_noexcept() 只在移动构造不会抛出异常(或者元素不能复制)时移动，否则复制，
+ *  用于重新配置空间：复制过程中抛出异常时原空间的元素完好无损
+*/
 template<typename InputIterator, typename ForwardIterator>
-inline ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result)
+inline ForwardIterator __uninitialized_move_aux(InputIterator first, InputIterator last, ForwardIterator result, __true_type)
+{
+    return MYSTL::copy(first, last, result);
+}
+
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator __uninitialized_move_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
+{
+    ForwardIterator cur = result;
+    try {
+        for(; first != last; ++first, ++cur)
+            construct(&*cur, std::move(*first));
+    } catch(...) {
+        destroy(result, cur);
+        throw;
+    }
+    return cur;
+}
+
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator uninitialized_move(InputIterator first, InputIterator last, ForwardIterator result)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename __type_traits<T>::is_POD_type is_POD;
+    return __uninitialized_move_aux(first, last, result, is_POD());
+}
+
+// 返回源区间与目的区间各自的结束位置
+template<typename InputIterator, typename Size, typename ForwardIterator>
+inline pair<InputIterator, ForwardIterator> uninitialized_move_n(InputIterator first, Size n, ForwardIterator result)
+{
+    ForwardIterator cur = result;
+    try {
+        for(; n > 0; --n, ++first, ++cur)
+            construct(&*cur, std::move(*first));
+    } catch(...) {
+        destroy(result, cur);
+        throw;
+    }
+    return pair<InputIterator, ForwardIterator>(first, cur);
+}
+
+// 原生指针可以直接求出区间，交给 uninitialized_move() 整块搬移
+template<typename T, typename Size, typename ForwardIterator>
+inline pair<T*, ForwardIterator> uninitialized_move_n(T* first, Size n, ForwardIterator result)
+{
+    return pair<T*, ForwardIterator>(first + n, uninitialized_move(first, first + n, result));
+}
+
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, ForwardIterator result, __true_type)
+{
+    return MYSTL::copy(first, last, result);
+}
+
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
 {
-    return __uninitialized_copy(first, last, result, value_type(result));
+    ForwardIterator cur = result;
+    try {
+        for(; first != last; ++first, ++cur)
+            construct(&*cur, std::move_if_noexcept(*first));
+    } catch(...) {
+        destroy(result, cur);
+        throw;
+    }
+    return cur;
+}
+
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator result)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename __type_traits<T>::is_POD_type is_POD;
+    return __uninitialized_move_if_noexcept_aux(first, last, result, is_POD());
+}
+
+/**
+ *  uninitialized_default_construct()  uninitialized_default_construct_n()
+ *  对 [first, last) 默认初始化(new (p) T，不带括号)：
+ *  具有 trivial 默认构造函数的类型什么都不做，内容保持未初始化，不会像值初始化那样清零
+*/
+template<typename ForwardIterator>
+inline void __uninitialized_default_construct_aux(ForwardIterator, ForwardIterator, __true_type)
+{
+}
+
+template<typename ForwardIterator>
+inline void __uninitialized_default_construct_aux(ForwardIterator first, ForwardIterator last, __false_type)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    ForwardIterator cur = first;
+    try {
+        for(; cur != last; ++cur)
+            new (static_cast<void*>(&*cur)) T;
+    } catch(...) {
+        destroy(first, cur);
+        throw;
+    }
+}
+
+template<typename ForwardIterator>
+inline void uninitialized_default_construct(ForwardIterator first, ForwardIterator last)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename __type_traits<T>::has_trivial_default_constructor trivial_ctor;
+    __uninitialized_default_construct_aux(first, last, trivial_ctor());
+}
+
+template<typename ForwardIterator, typename Size>
+inline ForwardIterator __uninitialized_default_construct_n_aux(ForwardIterator first, Size n, __true_type)
+{
+    for(; n > 0; --n)
+        ++first;
+    return first;
+}
+
+template<typename ForwardIterator, typename Size>
+inline ForwardIterator __uninitialized_default_construct_n_aux(ForwardIterator first, Size n, __false_type)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    ForwardIterator cur = first;
+    try {
+        for(; n > 0; --n, ++cur)
+            new (static_cast<void*>(&*cur)) T;
+    } catch(...) {
+        destroy(first, cur);
+        throw;
+    }
+    return cur;
+}
+
+template<typename ForwardIterator, typename Size>
+inline ForwardIterator uninitialized_default_construct_n(ForwardIterator first, Size n)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename __type_traits<T>::has_trivial_default_constructor trivial_ctor;
+    return __uninitialized_default_construct_n_aux(first, n, trivial_ctor());
+}
+
+/**
+ *  uninitialized_value_construct()  uninitialized_value_construct_n()
+ *  对 [first, last) 值初始化(new (p) T())：POD 类型清零，交给 fill()/fill_n()，原生指针时编译器会换成 memset
+*/
+template<typename ForwardIterator>
+inline void __uninitialized_value_construct_aux(ForwardIterator first, ForwardIterator last, __true_type)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    MYSTL::fill(first, last, T());
+}
+
+template<typename ForwardIterator>
+inline void __uninitialized_value_construct_aux(ForwardIterator first, ForwardIterator last, __false_type)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    ForwardIterator cur = first;
+    try {
+        for(; cur != last; ++cur)
+            new (static_cast<void*>(&*cur)) T();
+    } catch(...) {
+        destroy(first, cur);
+        throw;
+    }
+}
+
+template<typename ForwardIterator>
+inline void uninitialized_value_construct(ForwardIterator first, ForwardIterator last)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename __type_traits<T>::is_POD_type is_POD;
+    __uninitialized_value_construct_aux(first, last, is_POD());
+}
+
+template<typename ForwardIterator, typename Size>
+inline ForwardIterator __uninitialized_value_construct_n_aux(ForwardIterator first, Size n, __true_type)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    return MYSTL::fill_n(first, n, T());
+}
+
+template<typename ForwardIterator, typename Size>
+inline ForwardIterator __uninitialized_value_construct_n_aux(ForwardIterator first, Size n, __false_type)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    ForwardIterator cur = first;
+    try {
+        for(; n > 0; --n, ++cur)
+            new (static_cast<void*>(&*cur)) T();
+    } catch(...) {
+        destroy(first, cur);
+        throw;
+    }
+    return cur;
+}
+
+template<typename ForwardIterator, typename Size>
+inline ForwardIterator uninitialized_value_construct_n(ForwardIterator first, Size n)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename __type_traits<T>::is_POD_type is_POD;
+    return __uninitialized_value_construct_n_aux(first, n, is_POD());
 }
 
 /**
@@ -60,53 +273,89 @@ template<typename ForwardIterator, typename T>
 inline void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T& x, __false_type)
 {
     ForwardIterator cur = first;
-    for(; cur != last; ++cur)
-        construct(&(*cur), x);
-}
-
-template<typename ForwardIterator, typename T, typename T1>
-inline void __uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& x, T1)
-{
-    typedef typename __type_traits<T1>::is_POD_type is_POD;
-    __uninitialized_fill_aux(first, last, x, is_POD());
+    try {
+        for(; cur != last; ++cur)
+            construct(&*cur, x);
+    } catch(...) {
+        destroy(first, cur);
+        throw;
+    }
 }
 
 template<typename ForwardIterator, typename T>
 inline void uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& x)
 {
-    __uninitialized_fill(first, last, x, value_type(first) );
+    typedef typename iterator_traits<ForwardIterator>::value_type T1;
+    typedef typename __type_traits<T1>::is_POD_type is_POD;
+    __uninitialized_fill_aux(first, last, x, is_POD());
 }
 
 /**
  *  uninitialzed_fill_n()
- *  
+ *
 */
 template<typename ForwardIterator, typename Size, typename T>
-inline ForwardIterator uninitialized_fill_n(ForwardIterator first, Size n, const T& x)
+inline ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& x, __true_type)
+{
+    return MYSTL::fill_n(first, n, x);
+}
+
+template<typename ForwardIterator, typename Size, typename T>
+inline ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& x, __false_type)
 {
-    return __uninitialized_fill_n(first, n, x, value_type(first));
+    ForwardIterator cur = first;
+    try {
+        for(; n > 0; --n, ++cur)
+            construct(&*cur, x);
+    } catch(...) {
+        destroy(first, cur);
+        throw;
+    }
+    return cur;
 }
 
-template<typename ForwardIterator, typename Size, typename T, typename T1>
-inline ForwardIterator __uninitialized_fill_n(ForwardIterator first, Size n, const T& x, T1 *)
+template<typename ForwardIterator, typename Size, typename T>
+inline ForwardIterator uninitialized_fill_n(ForwardIterator first, Size n, const T& x)
 {
+    typedef typename iterator_traits<ForwardIterator>::value_type T1;
     typedef typename __type_traits<T1>::is_POD_type is_POD;
     return __uninitialized_fill_n_aux(first, n, x, is_POD());
 }
 
-template<typename ForwardIterator, typename Size, typename T>
-inline ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& x, __true_type)
+/**
+ *  uninitialized_relocate()
+ *  把 [first, last) 的元素搬到 result 开始的未初始化空间，并析构原来的元素，返回目的区间的结束位置
+ *  可以按位搬移的元素类型(见 is_trivially_relocatable)在原生指针之间直接 memmove，不调用任何构造与析构函数，
+ *  此时两个区间可以重叠；其他情况先逐个移动构造，全部成功后再析构原来的元素，两个区间不能重叠
+ *  移动构造抛出异常时已构造的元素全部析构，原区间的元素都还在(已移动过的处于被移动后的状态)，仍由调用者负责
+*/
+template<typename T>
+inline T* __uninitialized_relocate_aux(T* first, T* last, T* result, __true_type)
 {
-    return fill_n(first, n, x);
+    memmove(result, first, (last - first) * sizeof(T));
+    return result + (last - first);
 }
 
-template<typename ForwardIterator, typename Size, typename T>
-inline ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& x, __false_type)
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator __uninitialized_relocate_aux(InputIterator first, InputIterator last, ForwardIterator result, __true_type)
 {
-    ForwardIterator cur = first;
-    for(; n > 0; --n, ++cur)
-        construct(&*cur, x);
+    return __uninitialized_relocate_aux(first, last, result, __false_type());
+}
+
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator __uninitialized_relocate_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
+{
+    ForwardIterator cur = __uninitialized_move_aux(first, last, result, __false_type());
+    destroy(first, last);
     return cur;
 }
 
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator uninitialized_relocate(InputIterator first, InputIterator last, ForwardIterator result)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename is_trivially_relocatable<T>::type relocatable;
+    return __uninitialized_relocate_aux(first, last, result, relocatable());
+}
+
 #endif
@@ -1,6 +1,8 @@
 #ifndef _TYPE_TRAITS_H
 #define _TYPE_TRAITS_H
 
+#include <type_traits>
+
 /**
  *   利用 traits 技法改善对类型复制，构造，析构等效率
 */
@@ -9,153 +11,40 @@
 struct __true_type { };
 struct __false_type { };
 
-/**
- *  SGI默认将所有内嵌类型定义为 false_type
- *  默认定义最保守的值
-*/
-template <typename type>
-struct __type_traits {
-    typedef __true_type     this_dummy_member_must_be_first;
+// 将编译期的 bool 常量转换为 __true_type / __false_type
+template <bool cond>
+struct __bool_type { typedef __true_type type; };
 
-    typedef __false_type    has_trivial_default_constructor;
-    typedef __false_type    has_trivial_copy_constructor;
-    typedef __false_type    has_trivial_assignment_operator;
-    typedef __false_type    has_trivial_destructor;
-    typedef __false_type    is_POD_type;
-};
+template <>
+struct __bool_type<false> { typedef __false_type type; };
 
 /**
- *  利用 template 特例化对内置类型特例化
+ *  可以按位搬移(trivially relocatable)：把对象的字节复制到新地址，旧地址上的对象不再析构，
+ *  效果与移动构造后再析构旧对象相同
+ *  可以平凡复制的类型都满足；其他类型如果不保存指向自身的指针(例如大多数 string、unique_ptr 这类句柄)，
+ *  可以显式声明，之后 vector、small_vector 等容器增长时改为整块搬移：
+ *      template <> struct is_trivially_relocatable<my_string> : public __bool_type<true> { };
 */
-// char
-template <>
-struct __type_traits<char> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-//signed char
-template<>
-struct __type_traits<signed char> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-//unsigned char
-template<>
-struct __type_traits<unsigned char> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-//short
-template<>
-struct __type_traits<short> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-//unsigned short
-template<>
-struct __type_traits<unsigned short> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-// int
-template<>
-struct __type_traits<int> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-// unsignde int
-template<>
-struct __type_traits<unsigned int> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-// long
-template<>
-struct __type_traits<long> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-// unsigned long
-template<>
-struct __type_traits<unsigned long> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-// float
-template<>
-struct __type_traits<float> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
-
-// double
-template<>
-struct __type_traits<double> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
+template <typename T>
+struct is_trivially_relocatable : public __bool_type<std::is_trivially_copyable<T>::value> { };
 
-// long double
-template<>
-struct __type_traits<long double> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
-};
+/**
+ *  SGI 原本把所有内嵌类型默认定义为 __false_type，只有内置类型通过特例化标记为 __true_type，
+ *  用户定义的 struct 即使只有 int、float 成员也只能逐个构造、复制
+ *  这里改为由编译器提供的 std::is_trivially_* 推导，内置类型、指针以及由它们组成的 struct 都能自动得到
+ *  memmove / memset 的快速路径，也可以像以前一样对某个类型整体特例化 __type_traits
+ *  is_POD_type 表示可以直接在未初始化的空间上赋值、按字节复制，并且不需要析构
+*/
+template <typename type>
+struct __type_traits {
+    typedef __true_type     this_dummy_member_must_be_first;
 
-// C 原生指针
-template <typename T>
-struct __type_traits<T *> {
-    typedef __true_type     has_trivial_default_constructor;
-    typedef __true_type     has_trivial_copy_constructor;
-    typedef __true_type     has_trivial_assignment_operator;
-    typedef __true_type     has_trivial_destructor;
-    typedef __true_type     is_POD_type;
+    typedef typename __bool_type<std::is_trivially_default_constructible<type>::value>::type    has_trivial_default_constructor;
+    typedef typename __bool_type<std::is_trivially_copy_constructible<type>::value>::type       has_trivial_copy_constructor;
+    typedef typename __bool_type<std::is_trivially_copy_assignable<type>::value>::type          has_trivial_assignment_operator;
+    typedef typename __bool_type<std::is_trivially_destructible<type>::value>::type             has_trivial_destructor;
+    typedef typename __bool_type<std::is_trivial<type>::value
+                                 && std::is_trivially_copy_assignable<type>::value>::type       is_POD_type;
 };
 
-
 #endif
@@ -4,14 +4,44 @@
 #include "stl_alloc.h"
 #include "stl_unintialized.h"
 #include "algo.h"
+#include <type_traits>
 
 /**
  *  vector 内存配置为如果当前内存空间不足，则重新配置当前内存空间为当前空间的两倍
+ *  可以按位搬移的元素类型(见 is_trivially_relocatable)增长时通过配置器的 reallocate() 原地扩展或整块搬移，
+ *  不需要配置新空间、逐个复制再析构旧元素
+ *  其他元素类型重新配置时逐个移动到新空间(移动构造可能抛出异常且可以复制时退回复制)
+ *  vector 继承自己的内存配置器 data_allocator，从而持有一个 Alloc 对象，
+ *  复制、移动、交换时按照 __alloc_traits<Alloc> 的规则处理配置器
 */
 
 
-template <class T, class Alloc = __default_alloc_template<0>>
-class vector {
+/**
+ *  vector 的增长策略，作为第三个模板参数 Growth
+ *  grow(size, n) 返回当前有 size 个元素、还需要再放入 n 个元素时的新容量，结果不小于 size + n
+ *  fit_allocator 为 __true_type 时，新容量再上调到配置器实际给出的空间能容纳的元素个数(simple_alloc::good_size)，
+ *  这部分空间本来就会被区块的大小类别浪费掉，并且释放后的区块能被同类别的请求直接重用
+*/
+// 两倍增长，默认策略
+struct vector_growth_double {
+    typedef __false_type fit_allocator;
+    static size_t grow(size_t size, size_t n) { return size + (size > n ? size : n); }
+};
+
+// 1.5 倍增长，最多浪费 1/3 的空间，并且之前释放的几块空间加起来有机会容纳下一次的请求
+struct vector_growth_golden {
+    typedef __false_type fit_allocator;
+    static size_t grow(size_t size, size_t n) { return size + (size / 2 > n ? size / 2 : n); }
+};
+
+// 1.5 倍增长并按配置器的大小类别上调
+struct vector_growth_size_class {
+    typedef __true_type fit_allocator;
+    static size_t grow(size_t size, size_t n) { return vector_growth_golden::grow(size, n); }
+};
+
+template <class T, class Alloc = __default_alloc_template<0>, class Growth = vector_growth_double>
+class vector : protected simple_alloc<T, Alloc> {
 public:
  // SGI 容器类型标准
     using value_type = T;
@@ -23,16 +53,91 @@ public:
     using const_reference = const T&;
     using size_type = size_t;
     using difference_type = ptrdiff_t;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
 
 protected:
     // vector的内存配置器
     using data_allocator    =   simple_alloc<T, Alloc>;
+    using alloc_traits      =   __alloc_traits<Alloc>;
+    // 元素能否按位搬移
+    using relocatable       =   typename is_trivially_relocatable<T>::type;
+    using is_POD            =   typename __type_traits<T>::is_POD_type;
     iterator start;             // 表示目前使用空间开始地址
     iterator finish;            // 表示目前使用空间的尾部
     iterator end_of_storage;    // 表示目前已分配空间的尾部
 
-    // 在制定位置后面插入一个元素
-    void insert_aux(iterator position, const value_type& x);
+    // 在 position 处以 args 构造一个元素
+    template <class... Args>
+    void emplace_aux(iterator position, Args&&... args);
+    // 备用空间用完时，配置容量为 len 的新空间并在 position 处以 args 构造一个元素
+    template <class... Args>
+    void emplace_realloc(iterator position, size_type len, __true_type, Args&&... args);
+    template <class... Args>
+    void emplace_realloc(iterator position, size_type len, __false_type, Args&&... args);
+
+    // 备用空间用完时，配置容量为 len 的新空间并在 position 处插入 n 个 x
+    void insert_realloc(iterator position, size_type n, const T& x, size_type len, __true_type);
+    void insert_realloc(iterator position, size_type n, const T& x, size_type len, __false_type);
+
+    // 还需要放入 n 个元素时的新容量
+    size_type next_capacity(size_type n) const {
+        return fit_capacity(Growth::grow(size(), n), typename Growth::fit_allocator());
+    }
+    size_type fit_capacity(size_type len, __false_type) const { return len; }
+    size_type fit_capacity(size_type len, __true_type) const { return data_allocator::good_size(len); }
+
+    // 保证还能再放入 n 个元素，不够时按增长策略扩充容量
+    void reserve_more(size_type n) {
+        if(size_type(end_of_storage - finish) < n)
+            reserve_aux(next_capacity(n), relocatable());
+    }
+
+    // 将容量调整为 n，内容按位搬移
+    void reallocate_storage(size_type n) {
+        const size_type old_size = size();
+        start = data_allocator::reallocate(start, capacity(), n);
+        finish = start + old_size;
+        end_of_storage = start + n;
+    }
+
+    /**
+     *  可以按位搬移的元素在备用空间不够时插入 n 个元素：
+     *  relocate_gap() 通过 reallocate() 把容量调整为 len，并把 position 之后的元素整块后移 n 个位置，返回新的 position；
+     *  随后在空出的未初始化空间上构造新元素，构造失败时由 close_gap() 把后移的元素搬回原处
+    */
+    iterator relocate_gap(iterator position, size_type n, size_type len) {
+        const size_type index = position - start;
+        reallocate_storage(len);
+        position = start + index;
+        uninitialized_relocate(position, finish, position + n);
+        return position;
+    }
+    void close_gap(iterator position, size_type n) {
+        uninitialized_relocate(position + n, finish + n, position);
+    }
+
+    void reserve_aux(size_type n, __true_type) { reallocate_storage(n); }
+    void reserve_aux(size_type n, __false_type) {
+        const size_type old_size = size();
+        if(0 == n) { release(); return; }
+        // 新分配地址空间
+        iterator tmp = data_allocator::allocate(n);
+        // 将原地址空间的内容移动到新地址空间
+        try {
+            uninitialized_move_if_noexcept(start, finish, tmp);
+        } catch(...) {
+            data_allocator::deallocate(tmp, n);
+            throw;
+        }
+        // 回收原地址内存
+        destroy(start, finish);
+        deallocate();
+        // 调整vector迭代器
+        start = tmp;
+        finish = start + old_size;
+        end_of_storage = start + n;
+    }
 
     // 内存重分配
     void deallocate() {
@@ -53,16 +158,90 @@ protected:
         return result;
     }
 
+    // 区间构造，整数类型的"区间"是 n 个 x
+    template <class Integer>
+    void initialize_dispatch(Integer n, Integer x, __true_type) { fill_initialized((size_type)n, (T)x); }
+    template <class InputIterator>
+    void initialize_dispatch(InputIterator first, InputIterator last, __false_type)
+    { range_initialize(first, last, iterator_category(first)); }
+
     // [first, last) 区间之间的元素初始化vecot
+    template <class InputIterator>
+    void  range_initialize(InputIterator first, InputIterator last, input_iterator_tag)
+    {
+        start = finish = end_of_storage = nullptr;
+        try {
+            for(; first != last; ++first)
+                emplace_back(*first);
+        } catch(...) {
+            release();
+            throw;
+        }
+    }
+
+    // 前向迭代器可以先求出长度，一次配置
     template <class ForwardIterator>
     void  range_initialize(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
     {
-        difference_type n = distance(first, last);
+        difference_type n = ::distance(first, last);
         start = data_allocator::allocate(n);
         end_of_storage = start + n;
-        finish = uninitialized_copy(first, last, start);
+        try {
+            finish = uninitialized_copy(first, last, start);
+        } catch(...) {
+            data_allocator::deallocate(start, n);
+            throw;
+        }
+    }
+
+    // 释放全部元素与空间，回到空 vector 的状态
+    void release() {
+        destroy(start, finish);
+        deallocate();
+        start = finish = end_of_storage = nullptr;
     }
 
+    // 接管 x 的空间，x 变为空 vector
+    void steal(vector& x) {
+        start = x.start;
+        finish = x.finish;
+        end_of_storage = x.end_of_storage;
+        x.start = x.finish = x.end_of_storage = nullptr;
+    }
+
+    // 逐个复制 x 的元素，不改变配置器
+    void assign_elements(const vector& x);
+    // 逐个移动 x 的元素，不改变配置器，x 变为空 vector(保留空间)
+    void move_elements(vector& x);
+
+    // 区间插入与区间赋值，按照迭代器类型分别处理；整数类型的"区间"是 n 个 x
+    template <class Integer>
+    void insert_dispatch(iterator position, Integer n, Integer x, __true_type) { insert(position, (size_type)n, (T)x); }
+    template <class InputIterator>
+    void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+    { range_insert(position, first, last, iterator_category(first)); }
+
+    template <class InputIterator>
+    void range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag);
+    template <class ForwardIterator>
+    void range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+    // 备用空间不够时配置容量为 len 的新空间并在 position 处插入 [first, last) 的 n 个元素
+    template <class ForwardIterator>
+    void range_insert_realloc(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __true_type);
+    template <class ForwardIterator>
+    void range_insert_realloc(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __false_type);
+
+    template <class Integer>
+    void assign_dispatch(Integer n, Integer x, __true_type) { assign((size_type)n, (T)x); }
+    template <class InputIterator>
+    void assign_dispatch(InputIterator first, InputIterator last, __false_type)
+    { range_assign(first, last, iterator_category(first)); }
+
+    template <class InputIterator>
+    void range_assign(InputIterator first, InputIterator last, input_iterator_tag);
+    template <class ForwardIterator>
+    void range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
 public:
     // vecotr 容器对外开放的访问接口
     iterator begin() { return start; }
@@ -79,19 +258,60 @@ public:
     const_reference operator[] (size_type n) const { return *(begin() + n); }
 
     vector() : start(nullptr), finish(nullptr), end_of_storage(nullptr) {}
-    vector(size_type n, const T& value ) { fill_initialized(n, value); }
-    vector(int n, const T& value) { fill_initialized(n, value); }
-    vector(long n, const T& value) { fill_initialized(n, value); }
+    explicit vector(const Alloc& a) : data_allocator(a), start(nullptr), finish(nullptr), end_of_storage(nullptr) {}
+    vector(size_type n, const T& value, const Alloc& a = Alloc()) : data_allocator(a) { fill_initialized(n, value); }
+    vector(int n, const T& value, const Alloc& a = Alloc()) : data_allocator(a) { fill_initialized(n, value); }
+    vector(long n, const T& value, const Alloc& a = Alloc()) : data_allocator(a) { fill_initialized(n, value); }
 
     template <class InputIterator>
-    vector(InputIterator first, InputIterator last) { range_initialize(first, last, random_iterator_tag()); }     // [first, last)初始化迭代器
+    vector(InputIterator first, InputIterator last, const Alloc& a = Alloc()) : data_allocator(a)
+    {   // [first, last)初始化迭代器
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        initialize_dispatch(first, last, is_integer());
+    }
+
+    explicit vector(size_type n, const Alloc& a = Alloc()) : data_allocator(a) { fill_initialized(n, T()); }
 
-    explicit vector(size_type n) { fill_initialized(n, T()); }
+    vector(const vector& x) : data_allocator(alloc_traits::select_on_copy_construction(x.allocator()))
+    { range_initialize(x.begin(), x.end(), random_iterator_tag()); }
+
+    vector(const vector& x, const Alloc& a) : data_allocator(a)
+    { range_initialize(x.begin(), x.end(), random_iterator_tag()); }
+
+    // 移动构造，配置器随空间一起移动，只交换指针，不会抛出异常
+    vector(vector&& x) noexcept : data_allocator(x.allocator()) { steal(x); }
 
     ~vector() {
         destroy(start, finish);
         deallocate();
     }
+
+    vector& operator=(const vector& x) {
+        if(this != &x) {
+            // 配置器将被替换，原空间必须先交还给原来的配置器
+            if(__alloc_copy_changes(this->allocator(), x.allocator()))
+                release();
+            __alloc_copy_assign(this->allocator(), x.allocator());
+            assign_elements(x);
+        }
+        return *this;
+    }
+
+    vector& operator=(vector&& x) noexcept(__alloc_move_noexcept<Alloc>::value) {
+        if(this != &x) {
+            if(__alloc_move_steals(this->allocator(), x.allocator())) {
+                release();
+                __alloc_move_assign(this->allocator(), x.allocator());
+                steal(x);
+            } else {
+                // 配置器不同且不随之移动，x 的空间不能交给 this 释放，只能逐个移动元素
+                move_elements(x);
+            }
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return this->allocator(); }
     
     reference front() { return *begin(); }
     reference back()  { return *(end() - 1); }
@@ -102,27 +322,48 @@ public:
             ++finish;
         }
         else
-            insert_aux(end(), x);
+            emplace_aux(end(), x);
     }
 
-/*
-    // 右值完美转发
-    void push_back(value_type&& x) {
+    void push_back(value_type&& x) { emplace_back(std::move(x)); }
+
+    // 在尾部以 args 直接构造元素
+    template <class... Args>
+    reference emplace_back(Args&&... args) {
         if(finish != end_of_storage) {
-            construct(finish, std::forward<value_type>(x) );
-        } else {
-            insert_aux(end(), std::forward<value_type>(x));
+            construct(finish, std::forward<Args>(args)...);
+            ++finish;
         }
+        else
+            emplace_aux(end(), std::forward<Args>(args)...);
+        return back();
+    }
+
+    // 在 position 处以 args 直接构造元素，返回指向新元素的迭代器
+    template <class... Args>
+    iterator emplace(const_iterator position, Args&&... args) {
+        const size_type index = position - begin();
+        emplace_aux(start + index, std::forward<Args>(args)...);
+        return start + index;
     }
-*/
+
+    iterator insert(const_iterator position, const T& x) { return emplace(position, x); }
+    iterator insert(const_iterator position, T&& x) { return emplace(position, std::move(x)); }
 
     void pop_back() {
         --finish;
         destroy(finish);
     }
+    iterator erase(iterator first, iterator last) {
+        iterator i = MYSTL::move(last, finish, first);
+        destroy(i, finish);
+        finish = i;
+        return first;
+    }
+
     iterator erase(iterator position) {
         if (position + 1 != end())
-            copy(position + 1, finish, position);
+            MYSTL::move(position + 1, finish, position);
         --finish;
         destroy(finish);
         return position;
@@ -136,36 +377,144 @@ public:
     }
     void resize(size_type new_size) { resize(new_size, T()); }
 
+    /**
+     *  用作 I/O 缓冲区时跳过初始化的 resize，新增的元素随后由 read()、解码等直接写入
+     *  resize_default_init(n) 默认初始化新增的元素，对 char、uint32_t 这类 POD 类型相当于不初始化
+     *  resize_uninitialized(n) 与 append_uninitialized(n) 只能用于 POD 类型，新增的元素完全不初始化，
+     *  append_uninitialized(n) 在尾部追加 n 个元素并返回指向其中第一个的指针
+     *  容量不够时按增长策略扩充，多次追加仍然是均摊常数时间
+    */
+    void resize_default_init(size_type new_size) {
+        if(new_size < size()) {
+            erase(begin() + new_size, end());
+        } else {
+            reserve_more(new_size - size());
+            uninitialized_default_construct(finish, start + new_size);
+            finish = start + new_size;
+        }
+    }
+
+    void resize_uninitialized(size_type new_size) {
+        static_assert(std::is_same<is_POD, __true_type>::value, "resize_uninitialized requires a POD type");
+        if(new_size > size())
+            reserve_more(new_size - size());
+        finish = start + new_size;
+    }
+
+    pointer append_uninitialized(size_type n) {
+        static_assert(std::is_same<is_POD, __true_type>::value, "append_uninitialized requires a POD type");
+        reserve_more(n);
+        pointer result = finish;
+        finish += n;
+        return result;
+    }
+
     // 为vector预留空间
     void reserve(size_type n) {
-        if(capacity() < n) {     // 容器容量小于需求的容量n
-            const size_type old_size = size();
-            // 新分配地址空间
-            iterator tmp = data_allocator::allocate(n);
-            // 将原地址空间的内容复制到新地址空间
-            uninitialized_copy(start, finish, tmp);
-            // 回收原地址内存
-            destroy(start, finish);
-            deallocate();
-            // 调整vector迭代器
-            start = tmp;
-            finish = start + old_size;
-            end_of_storage = start + n;
-        }
+        if(capacity() < n)      // 容器容量小于需求的容量n
+            reserve_aux(n, relocatable());
+    }
+
+    // 释放多余的容量，容量变为 size()
+    void shrink_to_fit() {
+        if(capacity() != size())
+            reserve_aux(size(), relocatable());
     }
 
     void clear() { erase(begin(), end()); }
     void insert(iterator position, size_type n, const T& x);
 
-    void swap(vector<T, Alloc>& x) {
+    // 插入 [first, last)，前向迭代器只配置一次空间，可以按位复制的元素通过 memmove 复制
+    template <class InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        insert_dispatch(position, first, last, is_integer());
+    }
+
+    // 在尾部追加 [first, last) 或者整个区间 r
+    template <class InputIterator>
+    void append_range(InputIterator first, InputIterator last) { insert(end(), first, last); }
+    template <class Range>
+    void append_range(const Range& r) { insert(end(), r.begin(), r.end()); }
+
+    // 以 n 个 x 或者 [first, last) 替换全部内容
+    void assign(size_type n, const T& x);
+    template <class InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type is_integer;
+        assign_dispatch(first, last, is_integer());
+    }
+
+    void swap(vector& x) {
+        __alloc_swap(this->allocator(), x.allocator());
         MYSTL::swap(start, x.start);
         MYSTL::swap(finish, x.finish);
         MYSTL::swap(end_of_storage, x.end_of_storage);
     }
 };
 
-template<typename T, typename Alloc>
-void vector<T, Alloc>::insert(iterator position, size_type n, const T& x) {
+/**
+ *  缓冲区起始地址按 Align 对齐的 vector，默认按缓存行对齐
+ *  例如 aligned_vector<float, 32> 的 begin() 可以直接用于 AVX 的对齐读写
+*/
+template <class T, size_t Align = __CACHE_LINE>
+using aligned_vector = vector<T, __aligned_alloc_template<Align> >;
+
+template<typename T, typename Alloc, typename Growth>
+void vector<T, Alloc, Growth>::assign_elements(const vector& x) {
+    const size_type len = x.size();
+    if(len > capacity()) {
+        // 空间不足，配置新空间并复制
+        iterator tmp = data_allocator::allocate(len);
+        try {
+            uninitialized_copy(x.begin(), x.end(), tmp);
+        } catch(...) {
+            data_allocator::deallocate(tmp, len);
+            throw;
+        }
+        destroy(start, finish);
+        deallocate();
+        start = tmp;
+        end_of_storage = start + len;
+    } else if(size() >= len) {
+        iterator i = MYSTL::copy(x.begin(), x.end(), start);
+        destroy(i, finish);
+    } else {
+        MYSTL::copy(x.begin(), x.begin() + size(), start);
+        uninitialized_copy(x.begin() + size(), x.end(), finish);
+    }
+    finish = start + len;
+}
+
+template<typename T, typename Alloc, typename Growth>
+void vector<T, Alloc, Growth>::move_elements(vector& x) {
+    const size_type len = x.size();
+    if(len > capacity()) {
+        // 空间不足，配置新空间并移动
+        iterator tmp = data_allocator::allocate(len);
+        try {
+            uninitialized_move(x.begin(), x.end(), tmp);
+        } catch(...) {
+            data_allocator::deallocate(tmp, len);
+            throw;
+        }
+        destroy(start, finish);
+        deallocate();
+        start = tmp;
+        end_of_storage = start + len;
+    } else if(size() >= len) {
+        iterator i = MYSTL::move(x.begin(), x.end(), start);
+        destroy(i, finish);
+    } else {
+        MYSTL::move(x.begin(), x.begin() + size(), start);
+        uninitialized_move(x.begin() + size(), x.end(), finish);
+    }
+    finish = start + len;
+    x.clear();
+}
+
+template<typename T, typename Alloc, typename Growth>
+void vector<T, Alloc, Growth>::insert(iterator position, size_type n, const T& x) {
     if(n != 0) {    // 当 n != 0 才进行一下的操作
         if (size_type(end_of_storage - finish) >= n) {  // 当前剩余内容容量能够满足要求
             T x_copy = x;
@@ -174,86 +523,278 @@ void vector<T, Alloc>::insert(iterator position, size_type n, const T& x) {
             iterator old_finish = finish;
 
             if(elems_after > n) {   // 插入点之后元素个数 大于 插入元素个数
-                uninitialized_copy(finish - n, finish, finish);
+                uninitialized_move(finish - n, finish, finish);
                 finish += n;
-                MYSTL::copy_backward(position, old_finish - n, old_finish);
+                MYSTL::move_backward(position, old_finish - n, old_finish);
                 // 从插入点开始插入元素
                 MYSTL::fill(position, position + n, x_copy);
             } else {    // 插入点之后元素个数 少于 插入元素个数
                 uninitialized_fill_n(finish, n - elems_after, x_copy);
                 finish = finish + n - elems_after;
-                uninitialized_copy(position, old_finish, finish);
+                uninitialized_move(position, old_finish, finish);
                 finish += elems_after;
                 MYSTL::fill(position, old_finish, x_copy);
             }
         } else {    // 容器剩余空间容量不能够放入元素
             // 决定新空间的容量
-            const size_type old_size = size();
-            const size_type len = old_size + (old_size > n ? old_size : n);
-            // 配置新vector空间
-            iterator new_start = data_allocator::allocate(len);
-            iterator new_finish = new_start;
-            try {
-                new_finish = uninitialized_copy(start, position, new_start);
-                new_finish = uninitialized_fill_n(new_finish, n, x);
-                new_finish = uninitialized_copy(position, finish, new_finish);
-            } catch(...) {
-                // 发生异常则全部回滚
-                destroy(new_start, new_finish);
-                data_allocator::deallocate(new_start, len);
-                throw;
-            }
-            // 释放以前旧的vector
-            destroy(start, finish);
-            deallocate();
-
-            // 更新vector参数
-            start = new_start;
-            finish = new_finish;
-            end_of_storage = new_start + len;
+            const size_type len = next_capacity(n);
+            insert_realloc(position, n, x, len, relocatable());
         }
     }
 }
 
-template<typename T, typename Alloc>
-void vector<T, Alloc>::insert_aux(iterator position, const T & x) {
+template<typename T, typename Alloc, typename Growth>
+void vector<T, Alloc, Growth>::insert_realloc(iterator position, size_type n, const T& x, size_type len, __true_type) {
+    // x 可能是容器中的元素，先复制一份
+    T x_copy = x;
+    position = relocate_gap(position, n, len);
+    try {
+        uninitialized_fill(position, position + n, x_copy);
+    } catch(...) {
+        close_gap(position, n);
+        throw;
+    }
+    finish += n;
+}
+
+template<typename T, typename Alloc, typename Growth>
+void vector<T, Alloc, Growth>::insert_realloc(iterator position, size_type n, const T& x, size_type len, __false_type) {
+    // 配置新vector空间
+    iterator new_start = data_allocator::allocate(len);
+    iterator new_position = new_start + (position - start);
+    iterator new_finish = new_start;
+    bool filled = false;
+    try {
+        // x 可能是容器中的元素，在原有元素被移动之前先填入新元素
+        uninitialized_fill_n(new_position, n, x);
+        filled = true;
+        new_finish = uninitialized_move_if_noexcept(start, position, new_start);
+        new_finish = uninitialized_move_if_noexcept(position, finish, new_position + n);
+    } catch(...) {
+        // 发生异常则全部回滚
+        destroy(new_start, new_finish);
+        if(filled && new_finish <= new_position)
+            destroy(new_position, new_position + n);
+        data_allocator::deallocate(new_start, len);
+        throw;
+    }
+    // 释放以前旧的vector
+    destroy(start, finish);
+    deallocate();
+
+    // 更新vector参数
+    start = new_start;
+    finish = new_finish;
+    end_of_storage = new_start + len;
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class... Args>
+void vector<T, Alloc, Growth>::emplace_aux(iterator position, Args&&... args) {
     if(finish != end_of_storage) {  //备用空间还有剩余
-        construct(finish, *(finish - 1));
-        ++finish;
-        T x_copy = x;
-        MYSTL::copy_backward(position, finish - 2, finish - 1);
-        *position = x_copy;
+        if(position == finish) {
+            construct(finish, std::forward<Args>(args)...);
+            ++finish;
+        } else {
+            // args 可能引用容器中的元素，先构造出新元素再后移
+            T x_copy(std::forward<Args>(args)...);
+            construct(finish, std::move(*(finish - 1)));
+            ++finish;
+            MYSTL::move_backward(position, finish - 2, finish - 1);
+            *position = std::move(x_copy);
+        }
     }
     else {  //备用空间已经用完重新申请备用空间
-        const size_type old_size = size();
-        const size_type len = old_size != 0 ? 2 * old_size : 1;
+        const size_type len = next_capacity(1);
+        emplace_realloc(position, len, relocatable(), std::forward<Args>(args)...);
+    }
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class... Args>
+void vector<T, Alloc, Growth>::emplace_realloc(iterator position, size_type len, __true_type, Args&&... args) {
+    T x_copy(std::forward<Args>(args)...);
+    position = relocate_gap(position, 1, len);
+    try {
+        construct(position, std::move(x_copy));
+    } catch(...) {
+        close_gap(position, 1);
+        throw;
+    }
+    ++finish;
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class... Args>
+void vector<T, Alloc, Growth>::emplace_realloc(iterator position, size_type len, __false_type, Args&&... args) {
+    // 申请新的内存空间
+    iterator new_start = data_allocator::allocate(len);
+    iterator new_position = new_start + (position - start);
+    iterator new_finish = new_start;
+    bool constructed = false;
+    try {
+        // 先构造新元素，args 可能引用原空间中的元素
+        construct(new_position, std::forward<Args>(args)...);
+        constructed = true;
+        // 搬移前半元素
+        new_finish = uninitialized_move_if_noexcept(start, position, new_start);
+        ++new_finish;
+        // 搬移后半元素
+        new_finish = uninitialized_move_if_noexcept(position, finish, new_finish);
+    } catch(...) {
+        // "commit or rollback"
+        destroy(new_start, new_finish);
+        if(constructed && new_finish <= new_position)
+            destroy(new_position);
+        data_allocator::deallocate(new_start, len);
+        throw;
+    }
+    // 释放原地址空间
+    destroy(begin(), end());
+    deallocate();
+
+    // 调整迭代器，使其指向新vector地址
+    start = new_start;
+    finish = new_finish;
+    end_of_storage = new_start + len;
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class InputIterator>
+void vector<T, Alloc, Growth>::range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag) {
+    // 输入迭代器不能预先求出长度，只能逐个插入
+    for(; first != last; ++first) {
+        position = insert(position, *first);
+        ++position;
+    }
+}
 
-        // 申请新的内存空间
-        iterator new_start = data_allocator::allocate(len);
-        iterator new_finish = new_start;
+template<typename T, typename Alloc, typename Growth>
+template<class ForwardIterator>
+void vector<T, Alloc, Growth>::range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+    if(first == last)
+        return;
+    const size_type n = ::distance(first, last);
+    if(size_type(end_of_storage - finish) >= n) {  // 当前剩余内容容量能够满足要求
+        const size_type elems_after = finish - position;
+        iterator old_finish = finish;
+        if(elems_after > n) {
+            uninitialized_move(finish - n, finish, finish);
+            finish += n;
+            MYSTL::move_backward(position, old_finish - n, old_finish);
+            MYSTL::copy(first, last, position);
+        } else {
+            ForwardIterator mid = first;
+            ::advance(mid, elems_after);
+            uninitialized_copy(mid, last, finish);
+            finish += n - elems_after;
+            uninitialized_move(position, old_finish, finish);
+            finish += elems_after;
+            MYSTL::copy(first, mid, position);
+        }
+    } else {    // 一次配置足够的空间
+        range_insert_realloc(position, first, last, n, next_capacity(n), relocatable());
+    }
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class ForwardIterator>
+void vector<T, Alloc, Growth>::range_insert_realloc(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __true_type) {
+    position = relocate_gap(position, n, len);
+    try {
+        uninitialized_copy(first, last, position);
+    } catch(...) {
+        close_gap(position, n);
+        throw;
+    }
+    finish += n;
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class ForwardIterator>
+void vector<T, Alloc, Growth>::range_insert_realloc(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __false_type) {
+    iterator new_start = data_allocator::allocate(len);
+    iterator new_position = new_start + (position - start);
+    iterator new_finish = new_start;
+    bool copied = false;
+    try {
+        uninitialized_copy(first, last, new_position);
+        copied = true;
+        new_finish = uninitialized_move_if_noexcept(start, position, new_start);
+        new_finish = uninitialized_move_if_noexcept(position, finish, new_position + n);
+    } catch(...) {
+        // 发生异常则全部回滚
+        destroy(new_start, new_finish);
+        if(copied && new_finish <= new_position)
+            destroy(new_position, new_position + n);
+        data_allocator::deallocate(new_start, len);
+        throw;
+    }
+    destroy(start, finish);
+    deallocate();
+
+    start = new_start;
+    finish = new_finish;
+    end_of_storage = new_start + len;
+}
+
+template<typename T, typename Alloc, typename Growth>
+void vector<T, Alloc, Growth>::assign(size_type n, const T& x) {
+    if(n > capacity()) {
+        // 复制一份 x，它可能是容器中的元素
+        T x_copy = x;
+        release();
+        start = finish = data_allocator::allocate(n);
+        end_of_storage = start + n;
+        finish = uninitialized_fill_n(start, n, x_copy);
+    } else if(n > size()) {
+        MYSTL::fill(start, finish, x);
+        finish = uninitialized_fill_n(finish, n - size(), x);
+    } else {
+        MYSTL::fill(start, start + n, x);
+        erase(start + n, finish);
+    }
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class InputIterator>
+void vector<T, Alloc, Growth>::range_assign(InputIterator first, InputIterator last, input_iterator_tag) {
+    iterator cur = start;
+    for(; first != last && cur != finish; ++first, ++cur)
+        *cur = *first;
+    if(first == last)
+        erase(cur, finish);
+    else
+        range_insert(finish, first, last, input_iterator_tag());
+}
+
+template<typename T, typename Alloc, typename Growth>
+template<class ForwardIterator>
+void vector<T, Alloc, Growth>::range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+    const size_type len = ::distance(first, last);
+    if(len > capacity()) {
+        // 空间不足，配置新空间并复制
+        iterator tmp = data_allocator::allocate(len);
         try {
-            // 拷贝原内容到新的内存空间上
-            new_finish = uninitialized_copy(start, position, new_start);
-            // 插入新的元素
-            construct(new_finish, x);
-            ++new_finish;
-            // 插入后半元素
-            new_finish = uninitialized_copy(position, finish, new_finish);
+            uninitialized_copy(first, last, tmp);
         } catch(...) {
-            // "commit or rollback"
-            destroy(new_start, new_finish);
-            data_allocator::deallocate(new_start, len);
+            data_allocator::deallocate(tmp, len);
             throw;
         }
-        // 释放原地址空间
-        destroy(begin(), end());
-        deallocate();
-
-        // 调整迭代器，使其指向新vector地址
-        start = new_start;
-        finish = new_finish;
-        end_of_storage = new_start + len;
+        release();
+        start = tmp;
+        finish = end_of_storage = start + len;
+    } else if(size() >= len) {
+        erase(MYSTL::copy(first, last, start), finish);
+    } else {
+        ForwardIterator mid = first;
+        ::advance(mid, size());
+        MYSTL::copy(first, mid, start);
+        finish = uninitialized_copy(mid, last, finish);
     }
 }
 
+// vector<bool> 的特化版本
+#include "stl_bvector.h"
+
 #endif